@@ -0,0 +1,216 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <string.h>
+#include <QtEndian>
+#include "archivereader.h"
+
+
+/* Reading side, every get_ fails once the data runs short */
+struct archive_cursor {
+	const uchar *data;
+	size_t size;
+	size_t pos;
+	bool ok;
+};
+
+static const uchar* take(archive_cursor &in, size_t size) {
+	if (!in.ok || in.pos + size > in.size) {
+		in.ok = false;
+		return nullptr;
+	}
+	const uchar *data = in.data + in.pos;
+	in.pos += size;
+	return data;
+}
+
+static unsigned char get_u8(archive_cursor &in) {
+	const uchar *data = take(in, 1);
+	return data ? *data : 0;
+}
+
+static quint16 get_u16(archive_cursor &in) {
+	const uchar *data = take(in, 2);
+	return data ? qFromLittleEndian<quint16>(data) : 0;
+}
+
+static quint32 get_u32(archive_cursor &in) {
+	const uchar *data = take(in, 4);
+	return data ? qFromLittleEndian<quint32>(data) : 0;
+}
+
+static quint64 get_u64(archive_cursor &in) {
+	const uchar *data = take(in, 8);
+	return data ? qFromLittleEndian<quint64>(data) : 0;
+}
+
+static void get_str(archive_cursor &in, char *value, size_t size) {
+	quint16 length = get_u16(in);
+	const uchar *data = take(in, length);
+	if (data == nullptr) length = 0;
+	if (length >= size) length = size - 1;
+	if (length) memcpy(value, data, length);
+	value[length] = '\0';
+}
+
+static quint64 get_varint(archive_cursor &in) {
+	quint64 value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		const uchar *data = take(in, 1);
+		if (data == nullptr) return 0;
+		value |= (quint64)(*data & 0x7F) << shift;
+		if ((*data & 0x80) == 0) return value;
+	}
+	in.ok = false;
+	return 0;
+}
+
+static qint64 unzigzag(quint64 value) {
+	return (qint64)(value >> 1) ^ -(qint64)(value & 1);
+}
+
+
+ArchiveReader::ArchiveReader() {
+	m_data = nullptr;
+	m_size = 0;
+	m_session_start = 0;
+}
+
+
+ArchiveReader::~ArchiveReader() {
+	close();
+}
+
+
+bool ArchiveReader::open(const char *path) {
+	close();
+	m_file.setFileName(QString::fromUtf8(path));
+	if (!m_file.open(QIODevice::ReadOnly)) {
+		indigo_error("Can not open session archive '%s'\n", path);
+		return false;
+	}
+	m_size = m_file.size();
+	m_data = (m_size >= ARCHIVE_HEADER_SIZE) ? m_file.map(0, m_size) : nullptr;
+	if (m_data == nullptr || memcmp(m_data, ARCHIVE_MAGIC, 8) || qFromLittleEndian<quint32>(m_data + 8) != ARCHIVE_VERSION) {
+		indigo_error("'%s' is not a session archive of version %d\n", path, ARCHIVE_VERSION);
+		close();
+		return false;
+	}
+	m_session_start = qFromLittleEndian<quint64>(m_data + 12);
+
+	//  Only the headers are read here, a record cut short ends the archive
+	archive_cursor in = { m_data, (size_t)m_size, ARCHIVE_HEADER_SIZE, true };
+	while (in.pos + ARCHIVE_RECORD_HEADER <= in.size) {
+		archive_kind kind = (archive_kind)get_u8(in);
+		quint32 size = get_u32(in);
+		const uchar *payload = take(in, size);
+		if (payload == nullptr) break;
+
+		archive_cursor record = { payload, size, 0, true };
+		if (kind == ARCHIVE_SERIES) {
+			archive_series series;
+			memset(&series, 0, sizeof(series));
+			series.id = get_u32(record);
+			series.type = (indigo_property_type)get_u8(record);
+			get_str(record, series.device, sizeof(series.device));
+			get_str(record, series.property, sizeof(series.property));
+			get_str(record, series.item, sizeof(series.item));
+			if (!record.ok || series.id != (quint32)m_series.size()) break;
+			series.written = true;
+			m_series.append(series);
+		} else if (kind == ARCHIVE_BLOCK) {
+			block_ref block;
+			block.series = get_u32(record);
+			block.count = get_u32(record);
+			block.first = get_u64(record);
+			block.last = get_u64(record);
+			if (!record.ok || block.series >= (quint32)m_series.size() || block.count > ARCHIVE_BLOCK_SAMPLES) break;
+			block.data = payload + ARCHIVE_BLOCK_HEADER;
+			block.size = size - ARCHIVE_BLOCK_HEADER;
+			m_blocks.append(block);
+		}
+	}
+	indigo_debug("Session archive '%s': %d series, %d blocks\n", path, m_series.size(), m_blocks.size());
+	return true;
+}
+
+
+void ArchiveReader::close() {
+	if (m_data) m_file.unmap(m_data);
+	m_data = nullptr;
+	m_size = 0;
+	m_file.close();
+	m_series.clear();
+	m_blocks.clear();
+}
+
+
+int ArchiveReader::find_series(const char *device, const char *property, const char *item) const {
+	for (int i = 0; i < m_series.size(); i++) {
+		const archive_series &series = m_series[i];
+		if (!strcmp(series.device, device) && !strcmp(series.property, property) && !strcmp(series.item, item)) return i;
+	}
+	return -1;
+}
+
+
+bool ArchiveReader::query(int series, unsigned long long from, unsigned long long to, QVector<archive_sample> &samples) const {
+	if (series < 0 || series >= m_series.size()) return false;
+	indigo_property_type type = m_series[series].type;
+
+	//  Block times are kept relative to the session start
+	from = (from > m_session_start) ? from - m_session_start : 0;
+	to = (to > m_session_start) ? to - m_session_start : 0;
+	for (auto b = m_blocks.constBegin(); b != m_blocks.constEnd(); ++b) {
+		if (b->series != (quint32)series || b->last < from || b->first >= to) continue;
+
+		QByteArray columns = qUncompress(b->data, b->size);
+		archive_cursor in = { (const uchar *)columns.constData(), (size_t)columns.size(), 0, true };
+		int first = samples.size();
+		unsigned long long time = b->first;
+		samples.resize(first + b->count);
+		for (quint32 i = 0; i < b->count; i++) {
+			time += get_varint(in);
+			samples[first + i].usec = time;
+		}
+		quint64 bits = 0;
+		for (quint32 i = 0; i < b->count; i++) {
+			bits += (quint64)unzigzag(get_varint(in));
+			double value;
+			if (type == INDIGO_NUMBER_VECTOR) memcpy(&value, &bits, sizeof(value));
+			else value = (double)(qint64)bits;
+			samples[first + i].value = value;
+		}
+		if (!in.ok) {
+			indigo_error("Damaged block in session archive\n");
+			samples.resize(first);
+			return false;
+		}
+
+		//  Keep what is in the range, in absolute time
+		int kept = first;
+		for (int i = first; i < samples.size(); i++) {
+			if (samples[i].usec < from || samples[i].usec >= to) continue;
+			samples[kept].usec = samples[i].usec + m_session_start;
+			samples[kept].value = samples[i].value;
+			kept++;
+		}
+		samples.resize(kept);
+	}
+	return true;
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef ARCHIVEREADER_H
+#define ARCHIVEREADER_H
+
+#include <QFile>
+#include <QVector>
+#include "sessionarchive.h"
+
+struct archive_sample {
+	/* microseconds since the epoch */
+	unsigned long long usec;
+	double value;
+};
+
+
+/* Reads a session archive, also one still being written. The file is mapped,
+   open() only walks the record headers and query() decompresses only the
+   blocks of the series that overlap the asked time range.
+*/
+class ArchiveReader {
+public:
+	ArchiveReader();
+	~ArchiveReader();
+
+	bool open(const char *path);
+	void close();
+
+	unsigned long long session_start() const { return m_session_start; }
+	const QVector<archive_series>& series() const { return m_series; }
+	int find_series(const char *device, const char *property, const char *item) const;
+
+	/* Samples of the series in [from, to), times are microseconds since the epoch */
+	bool query(int series, unsigned long long from, unsigned long long to, QVector<archive_sample> &samples) const;
+
+private:
+	struct block_ref {
+		quint32 series;
+		quint32 count;
+		unsigned long long first;
+		unsigned long long last;
+		const uchar *data;
+		quint32 size;
+	};
+
+	QFile m_file;
+	uchar *m_data;
+	qint64 m_size;
+	unsigned long long m_session_start;
+	QVector<archive_series> m_series;
+	QVector<block_ref> m_blocks;
+};
+
+#endif // ARCHIVEREADER_H
@@ -0,0 +1,202 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+/* Property state styling benchmark. Builds synthetic property forms and
+   times one state change the way update_property_view() used to do it, a
+   setStyleSheet() with the rules of the new state on the form, against the
+   current way, the "state" dynamic property set on the styled widgets and
+   an unpolish() / polish() of each with the state rules in the application
+   style sheet. Reports microseconds per update as JSON.
+
+   bench_polish [--rows 4,16,64] [--updates N] [--qss FILE] [--json FILE]
+
+   Runs on the offscreen platform unless QT_QPA_PLATFORM says otherwise.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QLineEdit>
+#include <QList>
+#include <QPushButton>
+#include <QStringList>
+#include <QStyle>
+#include <QVBoxLayout>
+
+#ifndef BENCH_QSS_FILE
+#define BENCH_QSS_FILE "../resource/control_panel.qss"
+#endif
+
+/* The state cycle of an exposure */
+static const char *states[] = { "busy", "ok", "busy", "alert", "idle" };
+#define STATE_COUNT 5
+
+/* What update_property_view() passed to setStyleSheet() before */
+static const char *old_rules(const char *state) {
+	if (!strcmp(state, "busy"))
+		return
+			"#INDIGO_property { background-color: #353520; border: 0px}"
+			"QLineEdit#INDIGO_property { background-color: #252520}"
+			"QPushButton#INDIGO_property { background-color: #454522 }"
+			"QPushButton#INDIGO_property:focus { background-color: #505022 }";
+	if (!strcmp(state, "alert"))
+		return
+			"#INDIGO_property { background-color: #352222; border: 0px}"
+			"QLineEdit#INDIGO_property { background-color: #252222}"
+			"QPushButton#INDIGO_property { background-color: #452222 }"
+			"QPushButton#INDIGO_property:focus { background-color: #502222 }";
+	if (!strcmp(state, "ok"))
+		return
+			"#INDIGO_property { background-color: #203220; border: 0px}"
+			"QLineEdit#INDIGO_property { background-color: #202520}"
+			"QPushButton#INDIGO_property { background-color: #224322 }"
+			"QPushButton#INDIGO_property:focus { background-color: #225022 }";
+	return
+		"#INDIGO_property { background-color: #272727; border: 0px}"
+		"QLineEdit#INDIGO_property { background-color: #222222}"
+		"QPushButton#INDIGO_property { background-color: #323232 }"
+		"QPushButton#INDIGO_property:focus { background-color: #393939 }";
+}
+
+
+/* A number property form: label, value and target per item, Set and Reset */
+static QWidget* make_form(int rows, QList<QWidget*> &styled) {
+	QWidget *form = new QWidget();
+	QVBoxLayout *layout = new QVBoxLayout;
+	form->setLayout(layout);
+	for (int r = 0; r < rows; r++) {
+		QHBoxLayout *row = new QHBoxLayout;
+		QLabel *label = new QLabel(QString("Item %1").arg(r));
+		QLineEdit *value = new QLineEdit(QString::number(r * 1.5));
+		QLineEdit *target = new QLineEdit(QString::number(r * 1.5));
+		row->addWidget(label);
+		row->addWidget(value);
+		row->addWidget(target);
+		layout->addLayout(row);
+		styled << label << value << target;
+	}
+	QPushButton *set = new QPushButton("Set");
+	QPushButton *reset = new QPushButton("Reset");
+	layout->addWidget(set);
+	layout->addWidget(reset);
+	styled << set << reset;
+	for (QWidget *widget : styled) widget->setObjectName("INDIGO_property");
+	form->show();
+	QApplication::processEvents();
+	return form;
+}
+
+
+static double time_old(int rows, int updates, bool same_state) {
+	QList<QWidget*> styled;
+	QWidget *form = make_form(rows, styled);
+	QElapsedTimer timer;
+	timer.start();
+	for (int u = 0; u < updates; u++) {
+		form->setStyleSheet(old_rules(states[same_state ? 0 : u % STATE_COUNT]));
+	}
+	double usec = timer.nsecsElapsed() / 1000.0 / updates;
+	delete form;
+	return usec;
+}
+
+
+static double time_new(int rows, int updates) {
+	QList<QWidget*> styled;
+	QWidget *form = make_form(rows, styled);
+	QElapsedTimer timer;
+	timer.start();
+	for (int u = 0; u < updates; u++) {
+		const char *state = states[u % STATE_COUNT];
+		for (QWidget *widget : styled) {
+			widget->setProperty("state", state);
+			widget->style()->unpolish(widget);
+			widget->style()->polish(widget);
+		}
+	}
+	double usec = timer.nsecsElapsed() / 1000.0 / updates;
+	delete form;
+	return usec;
+}
+
+
+int main(int argc, char *argv[]) {
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) qputenv("QT_QPA_PLATFORM", "offscreen");
+	QApplication app(argc, argv);
+	QList<int> rows = { 4, 16, 64 };
+	int updates = 2000;
+	const char *qss_path = BENCH_QSS_FILE;
+	const char *json_path = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--rows") && i < argc - 1) {
+			rows.clear();
+			for (const QString &count : QString(argv[++i]).split(',', QString::SkipEmptyParts))
+				rows.append(count.toInt());
+		} else if (!strcmp(argv[i], "--updates") && i < argc - 1) {
+			updates = qMax(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--qss") && i < argc - 1) {
+			qss_path = argv[++i];
+		} else if (!strcmp(argv[i], "--json") && i < argc - 1) {
+			json_path = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--rows 4,16,64] [--updates N] [--qss FILE] [--json FILE]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	//  The state rules of the new path come from the application style sheet
+	QFile qss(qss_path);
+	if (!qss.open(QFile::ReadOnly | QFile::Text)) {
+		fprintf(stderr, "Can not open '%s'\n", qss_path);
+		return 1;
+	}
+	QString app_rules = QString::fromUtf8(qss.readAll());
+	qss.close();
+
+	FILE *json = json_path ? fopen(json_path, "w") : stdout;
+	if (json == nullptr) {
+		fprintf(stderr, "Can not open '%s'\n", json_path);
+		return 1;
+	}
+
+	fprintf(json, "{\n  \"updates\": %d,\n  \"platform\": \"%s\",\n  \"results\": [\n", updates, QApplication::platformName().toUtf8().constData());
+	bool first = true;
+	for (int count : rows) {
+		//  The old path ran with the same application style sheet in place
+		app.setStyleSheet(app_rules);
+		double old_change = time_old(count, updates, false);
+		double old_same = time_old(count, updates, true);
+		double new_change = time_new(count, updates);
+
+		if (!first) fprintf(json, ",\n");
+		first = false;
+		fprintf(json,
+			"    { \"rows\": %d, \"widgets\": %d, \"set_style_sheet_us\": %.2f, \"set_style_sheet_same_state_us\": %.2f, \"repolish_us\": %.2f, \"speedup\": %.2f }",
+			count, count * 3 + 2, old_change, old_same, new_change, new_change > 0 ? old_change / new_change : 0.0
+		);
+	}
+	fprintf(json, "\n  ]\n}\n");
+	if (json != stdout) fclose(json);
+	return 0;
+}
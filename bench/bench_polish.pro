@@ -0,0 +1,16 @@
+# Property state styling benchmark, build with:
+#   qmake bench_polish.pro && make && ./bench_polish --json results.json
+
+QT += core gui widgets
+CONFIG += console c++11 release
+CONFIG -= app_bundle
+
+TARGET = bench_polish
+OBJECTS_DIR = object
+MOC_DIR = moc
+
+DEFINES += QT_DEPRECATED_WARNINGS
+DEFINES += BENCH_QSS_FILE=\\\"$${PWD}/../resource/control_panel.qss\\\"
+
+SOURCES += \
+	bench_polish.cpp
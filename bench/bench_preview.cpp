@@ -0,0 +1,389 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+/* Preview pipeline benchmark. Generates synthetic star fields as FITS (BITPIX
+   8/16/32/-32, mono and every Bayer pattern), RAW and JPEG, runs them through
+   create_preview() and the preview pyramid and reports MP/s, per-stage times
+   and peak RSS as JSON. The peak RSS is per case where the
+   platform can reset it (Linux), the process peak so far otherwise.
+
+   bench_preview [--sizes 1,4,16,60,100] [--repeat N] [--json FILE]
+*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <sys/time.h>
+#include <QCoreApplication>
+#include <QBuffer>
+#include <QByteArray>
+#include <QImage>
+#include <QList>
+#include <QStringList>
+#if !defined(INDIGO_WINDOWS)
+#include <sys/resource.h>
+#endif
+#include "blobpreview.h"
+
+#define FITS_BLOCK 2880
+#define FITS_CARD 80
+
+typedef enum {
+	INPUT_FITS,
+	INPUT_RAW,
+	INPUT_JPEG
+} input_type;
+
+struct bench_case {
+	const char *name;
+	input_type type;
+	int bitpix;
+	const char *bayerpat;
+	int raw_signature;
+	const char *format;
+};
+
+static const bench_case cases[] = {
+	{ "fits8_mono", INPUT_FITS, 8, nullptr, 0, ".fits" },
+	{ "fits16_mono", INPUT_FITS, 16, nullptr, 0, ".fits" },
+	{ "fits32_mono", INPUT_FITS, 32, nullptr, 0, ".fits" },
+	{ "fits-32_mono", INPUT_FITS, -32, nullptr, 0, ".fits" },
+	{ "fits8_rggb", INPUT_FITS, 8, "RGGB", 0, ".fits" },
+	{ "fits8_bggr", INPUT_FITS, 8, "BGGR", 0, ".fits" },
+	{ "fits8_grbg", INPUT_FITS, 8, "GRBG", 0, ".fits" },
+	{ "fits8_gbrg", INPUT_FITS, 8, "GBRG", 0, ".fits" },
+	{ "fits16_rggb", INPUT_FITS, 16, "RGGB", 0, ".fits" },
+	{ "fits16_bggr", INPUT_FITS, 16, "BGGR", 0, ".fits" },
+	{ "fits16_grbg", INPUT_FITS, 16, "GRBG", 0, ".fits" },
+	{ "fits16_gbrg", INPUT_FITS, 16, "GBRG", 0, ".fits" },
+	{ "fits32_rggb", INPUT_FITS, 32, "RGGB", 0, ".fits" },
+	{ "fits-32_rggb", INPUT_FITS, -32, "RGGB", 0, ".fits" },
+	{ "raw_mono8", INPUT_RAW, 8, nullptr, INDIGO_RAW_MONO8, ".raw" },
+	{ "raw_mono16", INPUT_RAW, 16, nullptr, INDIGO_RAW_MONO16, ".raw" },
+	{ "raw_rgb24", INPUT_RAW, 8, nullptr, INDIGO_RAW_RGB24, ".raw" },
+	{ "raw_rgb48", INPUT_RAW, 16, nullptr, INDIGO_RAW_RGB48, ".raw" },
+	{ "jpeg", INPUT_JPEG, 8, nullptr, 0, ".jpeg" },
+};
+
+static const char *stage_names[PREVIEW_STAGE_COUNT] = { "parse", "histogram", "debayer", "stretch", "scale", "cache" };
+static double stage_ms[PREVIEW_STAGE_COUNT];
+
+
+static void record_stage(preview_stage stage, double ms) {
+	stage_ms[stage] += ms;
+}
+
+
+static double now_ms() {
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+
+/* On Linux the peak RSS is reset to the current RSS before each case, so
+   the reported peak is that of the case. Elsewhere it can not be reset and
+   the peak of the whole process so far is reported, see peak_rss_scope.
+*/
+static bool reset_peak_rss() {
+#if defined(__linux__)
+	FILE *file = fopen("/proc/self/clear_refs", "w");
+	if (file == NULL) return false;
+	bool ok = fputs("5", file) >= 0;
+	ok = (fclose(file) == 0) && ok;
+	return ok;
+#else
+	return false;
+#endif
+}
+
+
+/* peak resident set size since the last reset_peak_rss(), in kB */
+static long peak_rss_kb() {
+#if defined(__linux__)
+	FILE *file = fopen("/proc/self/status", "r");
+	if (file) {
+		char line[256];
+		long kb = -1;
+		while (fgets(line, sizeof(line), file)) {
+			if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+		}
+		fclose(file);
+		if (kb >= 0) return kb;
+	}
+#endif
+#if defined(INDIGO_WINDOWS)
+	return 0;
+#else
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+#if defined(INDIGO_MACOS) || defined(__APPLE__)
+	return usage.ru_maxrss / 1024;
+#else
+	return usage.ru_maxrss;
+#endif
+#endif
+}
+
+
+/* deterministic noise, the same input for every run */
+static unsigned int lcg_state;
+
+static inline unsigned int lcg() {
+	lcg_state = lcg_state * 1664525u + 1013904223u;
+	return lcg_state >> 8;
+}
+
+
+/* Sky background with noise and a sprinkle of gaussian stars, values in 0..1 */
+static float* make_star_field(int width, int height) {
+	float *pixels = (float *)malloc((size_t)width * height * sizeof(float));
+	lcg_state = 12345;
+	for (long i = 0; i < (long)width * height; i++) {
+		pixels[i] = 0.05f + (lcg() & 0xffff) / 65535.0f * 0.02f;
+	}
+	int stars = (int)((long)width * height / 5000);
+	for (int s = 0; s < stars; s++) {
+		int cx = lcg() % width;
+		int cy = lcg() % height;
+		float peak = 0.1f + (lcg() & 0xffff) / 65535.0f * 0.9f;
+		for (int dy = -4; dy <= 4; dy++) {
+			for (int dx = -4; dx <= 4; dx++) {
+				int x = cx + dx, y = cy + dy;
+				if (x < 0 || y < 0 || x >= width || y >= height) continue;
+				float v = pixels[(long)y * width + x] + peak * expf(-(dx * dx + dy * dy) / 3.0f);
+				pixels[(long)y * width + x] = v > 1.0f ? 1.0f : v;
+			}
+		}
+	}
+	return pixels;
+}
+
+
+static void fits_card(QByteArray &header, const char *format, ...) {
+	char card[FITS_CARD + 1];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(card, sizeof(card), format, args);
+	va_end(args);
+	QByteArray line(card);
+	line = line.leftJustified(FITS_CARD, ' ', true);
+	header.append(line);
+}
+
+
+static void put_be(unsigned char *out, const void *value, int size) {
+	const unsigned char *in = (const unsigned char *)value;
+	for (int i = 0; i < size; i++) out[i] = in[size - 1 - i];
+}
+
+
+static QByteArray make_fits(const float *pixels, int width, int height, int bitpix, const char *bayerpat) {
+	QByteArray header;
+	fits_card(header, "SIMPLE  = %20s", "T");
+	fits_card(header, "BITPIX  = %20d", bitpix);
+	fits_card(header, "NAXIS   = %20d", 2);
+	fits_card(header, "NAXIS1  = %20d", width);
+	fits_card(header, "NAXIS2  = %20d", height);
+	if (bitpix == 16) fits_card(header, "BZERO   = %20d", 32768);
+	if (bayerpat) fits_card(header, "BAYERPAT= '%s'", bayerpat);
+	fits_card(header, "END");
+	while (header.size() % FITS_BLOCK) header.append(' ');
+
+	int bytes = abs(bitpix) / 8;
+	long data_size = (long)width * height * bytes;
+	QByteArray fits(header.size() + ((data_size + FITS_BLOCK - 1) / FITS_BLOCK) * FITS_BLOCK, '\0');
+	memcpy(fits.data(), header.constData(), header.size());
+	unsigned char *out = (unsigned char *)fits.data() + header.size();
+	for (long i = 0; i < (long)width * height; i++, out += bytes) {
+		float v = pixels[i];
+		switch (bitpix) {
+		case 8: {
+			*out = (unsigned char)(v * 255);
+			break;
+		}
+		case 16: {
+			int16_t value = (int16_t)((int)(v * 65535) - 32768);
+			put_be(out, &value, 2);
+			break;
+		}
+		case 32: {
+			int32_t value = (int32_t)(v * 2147483647.0);
+			put_be(out, &value, 4);
+			break;
+		}
+		case -32: {
+			put_be(out, &v, 4);
+			break;
+		}
+		}
+	}
+	return fits;
+}
+
+
+static QByteArray make_raw(const float *pixels, int width, int height, int signature) {
+	int channels = (signature == INDIGO_RAW_RGB24 || signature == INDIGO_RAW_RGB48) ? 3 : 1;
+	int bytes = (signature == INDIGO_RAW_MONO16 || signature == INDIGO_RAW_RGB48) ? 2 : 1;
+	QByteArray raw(sizeof(indigo_raw_header) + (long)width * height * channels * bytes, '\0');
+	indigo_raw_header *header = (indigo_raw_header *)raw.data();
+	header->signature = signature;
+	header->width = width;
+	header->height = height;
+	unsigned char *out = (unsigned char *)raw.data() + sizeof(indigo_raw_header);
+	for (long i = 0; i < (long)width * height; i++) {
+		for (int c = 0; c < channels; c++) {
+			float v = pixels[i] * (1.0f - 0.2f * c);
+			if (bytes == 1) {
+				*out++ = (unsigned char)(v * 255);
+			} else {
+				uint16_t value = (uint16_t)(v * 65535);
+				memcpy(out, &value, 2);
+				out += 2;
+			}
+		}
+	}
+	return raw;
+}
+
+
+static QByteArray make_jpeg(const float *pixels, int width, int height) {
+	QImage image(width, height, QImage::Format_RGB888);
+	for (int y = 0; y < height; y++) {
+		unsigned char *line = image.scanLine(y);
+		for (int x = 0; x < width; x++) {
+			unsigned char v = (unsigned char)(pixels[(long)y * width + x] * 255);
+			*line++ = v;
+			*line++ = v;
+			*line++ = v;
+		}
+	}
+	QByteArray jpeg;
+	QBuffer buffer(&jpeg);
+	buffer.open(QIODevice::WriteOnly);
+	image.save(&buffer, "JPG", 90);
+	return jpeg;
+}
+
+
+static QByteArray make_input(const bench_case &c, const float *pixels, int width, int height) {
+	switch (c.type) {
+	case INPUT_FITS:
+		return make_fits(pixels, width, height, c.bitpix, c.bayerpat);
+	case INPUT_RAW:
+		return make_raw(pixels, width, height, c.raw_signature);
+	case INPUT_JPEG:
+		return make_jpeg(pixels, width, height);
+	}
+	return QByteArray();
+}
+
+
+static int compare_double(const void *a, const void *b) {
+	double da = *(const double *)a, db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+
+int main(int argc, char *argv[]) {
+	QCoreApplication app(argc, argv);
+	QList<double> sizes = { 1, 4, 16, 60, 100 };
+	int repeat = 5;
+	const char *json_path = nullptr;
+
+	for (int i = 1; i < argc; i++) {
+		if (!strcmp(argv[i], "--sizes") && i < argc - 1) {
+			sizes.clear();
+			for (const QString &size : QString(argv[++i]).split(',', QString::SkipEmptyParts))
+				sizes.append(size.toDouble());
+		} else if (!strcmp(argv[i], "--repeat") && i < argc - 1) {
+			repeat = qMax(1, atoi(argv[++i]));
+		} else if (!strcmp(argv[i], "--json") && i < argc - 1) {
+			json_path = argv[++i];
+		} else {
+			fprintf(stderr, "usage: %s [--sizes 1,4,16,60,100] [--repeat N] [--json FILE]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	FILE *json = json_path ? fopen(json_path, "w") : stdout;
+	if (json == nullptr) {
+		fprintf(stderr, "Can not open '%s'\n", json_path);
+		return 1;
+	}
+
+	indigo_set_log_level(INDIGO_LOG_ERROR);
+	set_preview_timing_callback(record_stage);
+
+	fprintf(json, "{\n  \"repeat\": %d,\n  \"results\": [\n", repeat);
+	bool first = true;
+	for (double mp : sizes) {
+		int width = ((int)sqrt(mp * 1e6 * 3 / 2)) & ~1;
+		int height = ((int)(width * 2 / 3)) & ~1;
+		double megapixels = (double)width * height / 1e6;
+		float *pixels = make_star_field(width, height);
+
+		for (const bench_case &c : cases) {
+			QByteArray input = make_input(c, pixels, width, height);
+			double *totals = (double *)malloc(repeat * sizeof(double));
+			double stages[PREVIEW_STAGE_COUNT] = { 0 };
+			bool supported = true;
+			bool case_peak = reset_peak_rss();
+
+			for (int r = 0; r < repeat; r++) {
+				memset(stage_ms, 0, sizeof(stage_ms));
+				double start = now_ms();
+				QImage *image = create_preview(c.format, (unsigned char *)input.data(), input.size());
+				if (image == nullptr) {
+					supported = false;
+					break;
+				}
+				preview_image *preview = new preview_image(*image);
+				delete image;
+				delete preview;
+				totals[r] = now_ms() - start;
+				for (int s = 0; s < PREVIEW_STAGE_COUNT; s++) stages[s] += stage_ms[s];
+			}
+
+			if (!first) fprintf(json, ",\n");
+			first = false;
+			fprintf(json, "    { \"case\": \"%s\", \"width\": %d, \"height\": %d, \"megapixels\": %.2f, \"input_bytes\": %d, ", c.name, width, height, megapixels, input.size());
+			if (supported) {
+				qsort(totals, repeat, sizeof(double), compare_double);
+				double median = totals[repeat / 2];
+				fprintf(json, "\"supported\": true, \"median_ms\": %.3f, \"min_ms\": %.3f, \"mp_per_s\": %.2f, \"stages_ms\": {", median, totals[0], megapixels / (median / 1000.0));
+				for (int s = 0; s < PREVIEW_STAGE_COUNT; s++)
+					fprintf(json, "%s\"%s\": %.3f", s ? ", " : " ", stage_names[s], stages[s] / repeat);
+				fprintf(json, " }, ");
+				fprintf(stderr, "%-14s %6.1f MP  %9.1f ms  %7.1f MP/s\n", c.name, megapixels, median, megapixels / (median / 1000.0));
+			} else {
+				fprintf(json, "\"supported\": false, ");
+				fprintf(stderr, "%-14s %6.1f MP  unsupported\n", c.name, megapixels);
+			}
+			fprintf(json, "\"peak_rss_kb\": %ld, \"peak_rss_scope\": \"%s\" }", peak_rss_kb(), case_peak ? "case" : "process");
+			free(totals);
+		}
+		free(pixels);
+	}
+	fprintf(json, "\n  ]\n}\n");
+	if (json != stdout) fclose(json);
+	return 0;
+}
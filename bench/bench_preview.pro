@@ -0,0 +1,40 @@
+# Preview pipeline benchmark, build with:
+#   qmake bench_preview.pro && make && ./bench_preview --json results.json
+
+QT += core gui
+CONFIG += console c++11 release
+CONFIG -= app_bundle
+
+TARGET = bench_preview
+OBJECTS_DIR = object
+MOC_DIR = moc
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += "$${PWD}/.." "$${PWD}/../indigo/indigo_libs"
+
+SOURCES += \
+	bench_preview.cpp \
+	../blobpreview.cpp \
+	../stats.cpp \
+	../fits/fits.c \
+	../debayer/debayer.c
+
+HEADERS += \
+	../blobpreview.h \
+	../stats.h \
+	../fits/fits.h \
+	../debayer/debayer.h \
+	../debayer/pixelformat.h
+
+unix {
+	INCLUDEPATH += "$${PWD}/../libjpeg"
+	LIBS += -L"$${PWD}/../libjpeg/.libs" -L"$${PWD}/../indigo/build/lib" -lindigo -ljpeg -ldl
+}
+
+win32 {
+	DEFINES += INDIGO_WINDOWS
+	SOURCES += \
+		../indigo/indigo_libs/indigo_bus.c \
+		../indigo/indigo_libs/indigo_version.c
+}
@@ -0,0 +1,208 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <time.h>
+#include <sys/time.h>
+#include <QDir>
+#include <QRegularExpression>
+#include "blobnaming.h"
+
+#if defined(INDIGO_WINDOWS)
+#define BLOB_PATH_SEPARATOR '\\'
+#else
+#define BLOB_PATH_SEPARATOR '/'
+#endif
+
+
+/* Device and property names may contain spaces and slashes */
+static void append_name(char *out, int *pos, int size, const char *name) {
+	for (const char *c = name; *c && *pos < size - 1; c++) {
+		out[(*pos)++] = (*c == '/' || *c == '\\' || *c == ' ' || *c == ':') ? '_' : *c;
+	}
+}
+
+
+static void expand_template(const char *name_template, const char *device, const char *property, const char *item, unsigned long sequence, char *out, int size) {
+	char buffer[64];
+	int pos = 0;
+
+	for (const char *c = name_template; *c && pos < size - 1; c++) {
+		if (*c != '%' || c[1] == '\0') {
+			out[pos++] = *c;
+			continue;
+		}
+		c++;
+		switch (*c) {
+		case 'd':
+			append_name(out, &pos, size, device);
+			break;
+		case 'p':
+			append_name(out, &pos, size, property);
+			break;
+		case 'i':
+			append_name(out, &pos, size, item);
+			break;
+		case 't': {
+			struct timeval tmnow;
+			gettimeofday(&tmnow, NULL);
+			time_t secs = tmnow.tv_sec;
+			strftime(buffer, sizeof(buffer), "%Y%m%d_%H%M%S", localtime(&secs));
+			append_name(out, &pos, size, buffer);
+			break;
+		}
+		case 'n':
+			snprintf(buffer, sizeof(buffer), "%05lu", sequence);
+			append_name(out, &pos, size, buffer);
+			break;
+		default:
+			out[pos++] = *c;
+			break;
+		}
+	}
+	out[pos] = '\0';
+}
+
+
+/* True if the template has a %n, %%n is a literal "%n" */
+bool BlobFileNamer::valid_template(const char *name_template) {
+	for (const char *c = name_template; *c; c++) {
+		if (*c != '%' || c[1] == '\0') continue;
+		c++;
+		if (*c == 'n') return true;
+	}
+	return false;
+}
+
+
+BlobFileNamer::BlobFileNamer() : m_unsaved(0) {
+	pthread_mutex_init(&m_mutex, nullptr);
+	load();
+}
+
+
+void BlobFileNamer::make_name(const char *directory, const char *device, const char *property, const char *item, const char *format, char *file_name, int size) {
+	char name_template[sizeof(conf.blob_name_template)];
+	char name[PATH_LEN];
+
+	strncpy(name_template, conf.blob_name_template, sizeof(name_template));
+	name_template[sizeof(name_template) - 1] = '\0';
+	if (!valid_template(name_template)) strcpy(name_template, BLOB_NAME_TEMPLATE_DEFAULT);
+
+	unsigned long sequence = next_sequence(directory, name_template);
+	expand_template(name_template, device, property, item, sequence, name, sizeof(name));
+	snprintf(file_name, size, "%s%c%s%s", directory, BLOB_PATH_SEPARATOR, name, format);
+}
+
+
+unsigned long BlobFileNamer::next_sequence(const char *directory, const char *name_template) {
+	QString key(directory);
+
+	pthread_mutex_lock(&m_mutex);
+	if (!m_scanned.contains(key)) {
+		unsigned long found = scan_directory(directory, name_template);
+		if (found > m_counters.value(key, 0)) m_counters.insert(key, found);
+		m_scanned.insert(key, true);
+	}
+	unsigned long sequence = m_counters.value(key, 0);
+	m_counters.insert(key, sequence + 1);
+	if (++m_unsaved >= BLOB_COUNTERS_SAVE_EVERY) save_locked();
+	pthread_mutex_unlock(&m_mutex);
+	return sequence;
+}
+
+
+/* Returns the number after the highest sequence already used in the directory */
+unsigned long BlobFileNamer::scan_directory(const char *directory, const char *name_template) {
+	QString pattern("^");
+	bool has_sequence = false;
+
+	for (const char *c = name_template; *c; c++) {
+		if (*c != '%' || c[1] == '\0') {
+			pattern.append(QRegularExpression::escape(QString(QChar(*c))));
+			continue;
+		}
+		c++;
+		switch (*c) {
+		case 'd':
+		case 'p':
+		case 'i':
+		case 't':
+			pattern.append(".*?");
+			break;
+		case 'n':
+			/* only the first %n is captured */
+			pattern.append(has_sequence ? "\\d+" : "(\\d+)");
+			has_sequence = true;
+			break;
+		default:
+			pattern.append(QRegularExpression::escape(QString(QChar(*c))));
+			break;
+		}
+	}
+	if (!has_sequence) return 0;
+	pattern.append("(\\..*)?$");
+
+	QRegularExpression re(pattern);
+	unsigned long next = 0;
+	QStringList entries = QDir(directory).entryList(QDir::Files);
+	for (const QString &entry : entries) {
+		QRegularExpressionMatch match = re.match(entry);
+		if (!match.hasMatch()) continue;
+		unsigned long sequence = match.captured(1).toULong();
+		if (sequence + 1 > next) next = sequence + 1;
+	}
+	indigo_debug("%s(): %s has %d files, next sequence %lu\n", __FUNCTION__, directory, entries.size(), next);
+	return next;
+}
+
+
+void BlobFileNamer::load() {
+	char filename[PATH_LEN];
+	char directory[4096];
+	unsigned long sequence;
+
+	snprintf(filename, PATH_LEN, "%s/%s", config_path, BLOB_COUNTERS_FILENAME);
+	FILE *file = fopen(filename, "r");
+	if (file == nullptr) return;
+	while (fscanf(file, "%lu %4095[^\n]\n", &sequence, directory) == 2) {
+		m_counters.insert(QString(directory), sequence);
+	}
+	fclose(file);
+}
+
+
+void BlobFileNamer::save() {
+	pthread_mutex_lock(&m_mutex);
+	save_locked();
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void BlobFileNamer::save_locked() {
+	char filename[PATH_LEN];
+
+	m_unsaved = 0;
+	snprintf(filename, PATH_LEN, "%s/%s", config_path, BLOB_COUNTERS_FILENAME);
+	FILE *file = fopen(filename, "w");
+	if (file == nullptr) return;
+	for (auto i = m_counters.constBegin(); i != m_counters.constEnd(); ++i) {
+		fprintf(file, "%lu %s\n", i.value(), i.key().toUtf8().constData());
+	}
+	fclose(file);
+}
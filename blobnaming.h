@@ -0,0 +1,75 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef BLOBNAMING_H
+#define BLOBNAMING_H
+
+#include <pthread.h>
+#include <QHash>
+#include <QString>
+#include "conf.h"
+
+#define BLOB_COUNTERS_FILENAME "indigo_control_panel.counters"
+#define BLOB_NAME_TEMPLATE_DEFAULT "blob_%n"
+
+/* Counters are written out after this many new names and on exit,
+   a lost update is recovered by the directory scan on the next start
+*/
+#define BLOB_COUNTERS_SAVE_EVERY 64
+
+/* Names tried before giving up when the files already exist */
+#define BLOB_NAME_MAX_TRIES 1000
+
+
+/* Hands out file names for saved BLOBs built from conf.blob_name_template:
+     %d device, %p property, %i item, %t local time, %n sequence, %% percent
+   A template must contain %n, otherwise every name would be the same and
+   the default template is used instead. The sequence is kept per directory.
+   It is recovered once per directory from the saved counters and a single
+   scan of the directory, after that every name costs one counter increment.
+*/
+class BlobFileNamer {
+public:
+	static BlobFileNamer& instance();
+
+	static bool valid_template(const char *name_template);
+	void make_name(const char *directory, const char *device, const char *property, const char *item, const char *format, char *file_name, int size);
+	void save();
+
+private:
+	BlobFileNamer();
+
+	unsigned long next_sequence(const char *directory, const char *name_template);
+	unsigned long scan_directory(const char *directory, const char *name_template);
+	void load();
+	void save_locked();
+
+	QHash<QString, unsigned long> m_counters;
+	QHash<QString, bool> m_scanned;
+	pthread_mutex_t m_mutex;
+	int m_unsaved;
+};
+
+inline BlobFileNamer& BlobFileNamer::instance() {
+	static BlobFileNamer* me = nullptr;
+	if (!me) me = new BlobFileNamer();
+	return *me;
+}
+
+#endif // BLOBNAMING_H
@@ -20,10 +20,35 @@
 #include <debayer/debayer.h>
 #include <debayer/pixelformat.h>
 #include "blobpreview.h"
+#include "stats.h"
 #include <QPainter>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <sys/time.h>
 
 blob_preview_cache preview_cache;
 static preview_stretch preview_stretch_level = STRETCH_NORMAL;
+static QAtomicInt preview_generation;
+static preview_timing_callback preview_timing = nullptr;
+
+void set_preview_timing_callback(preview_timing_callback callback) {
+	preview_timing = callback;
+}
+
+static double stage_start() {
+	if (preview_timing == nullptr) return 0;
+	struct timeval now;
+	gettimeofday(&now, NULL);
+	return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+/* Reports the stage and returns the time it ended, to start the next one */
+static double stage_done(preview_stage stage, double start) {
+	if (preview_timing == nullptr) return 0;
+	double now = stage_start();
+	preview_timing(stage, now - start);
+	return now;
+}
 
 const float preview_stretch_lut[] = {
 	0.0,
@@ -31,15 +56,48 @@ const float preview_stretch_lut[] = {
 	0.01
 };
 
-QString blob_preview_cache::create_key(indigo_property *property, indigo_item *item) {
-	QString key(property->device);
+preview_image::preview_image(const QImage &image): QImage(image) {
+	double start = stage_start();
+	m_generation = preview_generation.fetchAndAddRelaxed(1) + 1;
+	const QImage *previous = this;
+	while (previous->width() > PREVIEW_TILE_SIZE || previous->height() > PREVIEW_TILE_SIZE) {
+		int width = qMax(1, previous->width() / 2);
+		int height = qMax(1, previous->height() / 2);
+		m_levels.append(previous->scaled(width, height, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+		previous = &m_levels.last();
+	}
+	stage_done(PREVIEW_STAGE_SCALE, start);
+}
+
+
+void preview_image::mark(const char *text) {
+	for (int n = 0; n < level_count(); n++) {
+		QImage &image = (n == 0) ? *this : m_levels[n - 1];
+		QPainter painter(&image);
+		painter.setPen(QColor(241, 183, 1));
+		QFont ft = painter.font();
+		ft.setPixelSize(qMax(1, image.height()/15));
+		painter.setFont(ft);
+		painter.drawText(image.width()/20, image.height()/20, image.width(), image.height(), Qt::AlignTop & Qt::AlignLeft, text);
+	}
+	m_generation = preview_generation.fetchAndAddRelaxed(1) + 1;
+}
+
+
+QString preview_key(const char *device, const char *property, const char *item) {
+	QString key(device);
 	key.append(".");
-	key.append(property->name);
+	key.append(property);
 	key.append(".");
-	key.append(item->name);
+	key.append(item);
 	return key;
 }
 
+
+QString blob_preview_cache::create_key(indigo_property *property, indigo_item *item) {
+	return preview_key(property->device, property->name, item->name);
+}
+
 void blob_preview_cache::set_stretch_level(preview_stretch level) {
 	preview_stretch_level = level;
 }
@@ -47,34 +105,35 @@ void blob_preview_cache::set_stretch_level(preview_stretch level) {
 bool blob_preview_cache::_remove(indigo_property *property, indigo_item *item) {
 	QString key = create_key(property, item);
 	if (contains(key)) {
-		QImage *preview = value(key);
+		preview_image *preview = value(key);
 		indigo_debug("preview: %s(%s) == %p\n", __FUNCTION__, key.toUtf8().constData(), preview);
 		if (preview != nullptr)
 			delete(preview);
+		Stats::instance().add(STAT_PREVIEW_CACHE_EVICTIONS);
 	} else {
 		indigo_debug("preview: %s(%s) - no preview\n", __FUNCTION__, key.toUtf8().constData());
 	}
-	return (bool)QHash::remove(key);
+	bool removed = (bool)QHash::remove(key);
+	Stats::instance().set(STAT_PREVIEW_CACHE_SIZE, size());
+	return removed;
 }
 
 
 bool blob_preview_cache::obsolete(indigo_property *property, indigo_item *item) {
+	pthread_mutex_lock(&preview_mutex);
 	QString key = create_key(property, item);
 	if (contains(key)) {
-		QImage *preview = value(key);
+		preview_image *preview = value(key);
 		indigo_debug("preview: %s(%s) == %p\n", __FUNCTION__, key.toUtf8().constData(), preview);
 		if (preview != nullptr) {
-			QPainter painter(preview);
-			painter.setPen(QColor(241, 183, 1));
-			QFont ft = painter.font();
-			ft.setPixelSize(preview->height()/15);
-			painter.setFont(ft);
-			painter.drawText(preview->width()/20, preview->height()/20, preview->width(), preview->height(), Qt::AlignTop & Qt::AlignLeft, "\u231b Busy...");
+			preview->mark("\u231b Busy...");
+			pthread_mutex_unlock(&preview_mutex);
 			return true;
 		}
 	} else {
 		indigo_debug("preview: %s(%s) - no preview\n", __FUNCTION__, key.toUtf8().constData());
 	}
+	pthread_mutex_unlock(&preview_mutex);
 	return false;
 }
 
@@ -83,10 +142,15 @@ bool blob_preview_cache::create(indigo_property *property, indigo_item *item) {
 	pthread_mutex_lock(&preview_mutex);
 	QString key = create_key(property, item);
 	_remove(property, item);
-	QImage *preview = create_preview(property, item);
-	indigo_debug("preview: %s(%s) == %p\n", __FUNCTION__, key.toUtf8().constData(), preview);
-	if (preview != nullptr) {
+	QImage *image = create_preview(property, item);
+	indigo_debug("preview: %s(%s) == %p\n", __FUNCTION__, key.toUtf8().constData(), image);
+	if (image != nullptr) {
+		preview_image *preview = new preview_image(*image);
+		double start = stage_start();
 		insert(key, preview);
+		stage_done(PREVIEW_STAGE_CACHE, start);
+		Stats::instance().set(STAT_PREVIEW_CACHE_SIZE, size());
+		delete image;
 		pthread_mutex_unlock(&preview_mutex);
 		return true;
 	}
@@ -95,21 +159,51 @@ bool blob_preview_cache::create(indigo_property *property, indigo_item *item) {
 }
 
 
-QImage* blob_preview_cache::get(indigo_property *property, indigo_item *item) {
+preview_image* blob_preview_cache::get(indigo_property *property, indigo_item *item) {
 	pthread_mutex_lock(&preview_mutex);
 	QString key = create_key(property, item);
 	if (contains(key)) {
-		QImage *preview = value(key);
+		preview_image *preview = value(key);
 		indigo_debug("preview: %s(%s) == %p\n", __FUNCTION__, key.toUtf8().constData(), preview);
 		pthread_mutex_unlock(&preview_mutex);
+		Stats::instance().add(STAT_PREVIEW_CACHE_HITS);
 		return preview;
 	}
 	indigo_debug("preview: %s(%s) - no preview\n", __FUNCTION__, key.toUtf8().constData());
 	pthread_mutex_unlock(&preview_mutex);
+	Stats::instance().add(STAT_PREVIEW_CACHE_MISSES);
 	return nullptr;
 }
 
 
+/* Copies share the pixels, the copy stays valid when the cached preview is replaced */
+bool blob_preview_cache::copy(indigo_property *property, indigo_item *item, preview_image *preview) {
+	pthread_mutex_lock(&preview_mutex);
+	QString key = create_key(property, item);
+	preview_image *cached = value(key, nullptr);
+	if (cached != nullptr) *preview = *cached;
+	pthread_mutex_unlock(&preview_mutex);
+	Stats::instance().add(cached != nullptr ? STAT_PREVIEW_CACHE_HITS : STAT_PREVIEW_CACHE_MISSES);
+	return cached != nullptr;
+}
+
+
+/* Takes ownership of a preview built elsewhere, like the live preview worker */
+void blob_preview_cache::insert_preview(const QString &key, preview_image *preview) {
+	double start = stage_start();
+	pthread_mutex_lock(&preview_mutex);
+	preview_image *old = value(key, nullptr);
+	if (old != nullptr) {
+		delete(old);
+		Stats::instance().add(STAT_PREVIEW_CACHE_EVICTIONS);
+	}
+	insert(key, preview);
+	Stats::instance().set(STAT_PREVIEW_CACHE_SIZE, size());
+	pthread_mutex_unlock(&preview_mutex);
+	stage_done(PREVIEW_STAGE_CACHE, start);
+}
+
+
 bool blob_preview_cache::remove(indigo_property *property, indigo_item *item) {
 	pthread_mutex_lock(&preview_mutex);
 	bool success = _remove(property, item);
@@ -120,10 +214,12 @@ bool blob_preview_cache::remove(indigo_property *property, indigo_item *item) {
 // Related Functions
 
 QImage* create_jpeg_preview(unsigned char *jpg_buffer, unsigned long jpg_size) {
+	double start = stage_start();
 #if !defined(USE_LIBJPEG)
 
 	QImage* img = new QImage();
 	img->loadFromData((const uchar*)jpg_buffer, jpg_size, "JPG");
+	stage_done(PREVIEW_STAGE_PARSE, start);
 	return img;
 
 #else // INDIGO Mac and Linux
@@ -182,6 +278,7 @@ QImage* create_jpeg_preview(unsigned char *jpg_buffer, unsigned long jpg_size) {
 	}
 
 	free(bmp_buffer);
+	stage_done(PREVIEW_STAGE_PARSE, start);
 	return img;
 #endif
 }
@@ -192,6 +289,7 @@ QImage* create_fits_preview(unsigned char *raw_fits_buffer, unsigned long fits_s
 	int *hist;
 	unsigned int pix_format = 0;
 
+	double start = stage_start();
 	int res = fits_read_header(raw_fits_buffer, fits_size, &header);
 	if (res != FITS_OK) {
 		indigo_error("FITS: Error parsing header");
@@ -217,7 +315,9 @@ QImage* create_fits_preview(unsigned char *raw_fits_buffer, unsigned long fits_s
 
 	char *fits_data = (char*)malloc(fits_get_buffer_size(&header));
 
+	start = stage_done(PREVIEW_STAGE_PARSE, start);
 	res = fits_process_data_with_hist(raw_fits_buffer, fits_size, &header, fits_data, hist);
+	stage_done(PREVIEW_STAGE_HISTOGRAM, start);
 	if (res != FITS_OK) {
 		indigo_error("FITS: Error processing data");
 		return nullptr;
@@ -294,6 +394,7 @@ QImage* create_raw_preview(unsigned char *raw_image_buffer, unsigned long raw_si
 		return nullptr;
 	}
 
+	double start = stage_start();
 	if ((header->signature == INDIGO_RAW_MONO16) ||
 	    (header->signature == INDIGO_RAW_RGB48)) {
 		hist = (int*)malloc(65536*sizeof(int));
@@ -315,6 +416,8 @@ QImage* create_raw_preview(unsigned char *raw_image_buffer, unsigned long raw_si
 		return nullptr;
 	}
 
+	stage_done(PREVIEW_STAGE_HISTOGRAM, start);
+
 	QImage *img = create_preview(header->width, header->height,
 	        pix_format, raw_data, hist, preview_stretch_lut[preview_stretch_level]);
 
@@ -324,6 +427,7 @@ QImage* create_raw_preview(unsigned char *raw_image_buffer, unsigned long raw_si
 
 
 QImage* create_preview(int width, int height, int pix_format, char *image_data, int *hist, double white_threshold) {
+	double start = stage_start();
 	int range, max, min = 0, sum;
 	int pix_cnt = width * height;
 	int thresh = white_threshold * pix_cnt;
@@ -466,7 +570,9 @@ QImage* create_preview(int width, int height, int pix_format, char *image_data,
 	} else if ((pix_format == PIX_FMT_SBGGR8) || (pix_format == PIX_FMT_SGBRG8) ||
 		       (pix_format == PIX_FMT_SGRBG8) || (pix_format == PIX_FMT_SRGGB8)) {
 		uint8_t* rgb_data = (uint8_t*)malloc(width*height*3);
+		double debayer_start = stage_start();
 		bayer_to_rgb24((unsigned char*)image_data, rgb_data, width, height, pix_format);
+		start += stage_done(PREVIEW_STAGE_DEBAYER, debayer_start) - debayer_start;
 		uint8_t* buf = (uint8_t*)rgb_data;
 		int index = 0;
 		for (int y = 0; y < height; ++y) {
@@ -488,7 +594,9 @@ QImage* create_preview(int width, int height, int pix_format, char *image_data,
 	} else if ((pix_format == PIX_FMT_SBGGR16) || (pix_format == PIX_FMT_SGBRG16) ||
 		       (pix_format == PIX_FMT_SGRBG16) || (pix_format == PIX_FMT_SRGGB16)) {
 		uint16_t* rgb_data = (uint16_t*)malloc(width*height*6);
+		double debayer_start = stage_start();
 		bayer_to_rgb48((const uint16_t*)image_data, rgb_data, width, height, pix_format);
+		start += stage_done(PREVIEW_STAGE_DEBAYER, debayer_start) - debayer_start;
 		uint16_t* buf = (uint16_t*)rgb_data;
 		int index = 0;
 		for (int y = 0; y < height; ++y) {
@@ -511,48 +619,44 @@ QImage* create_preview(int width, int height, int pix_format, char *image_data,
 		indigo_error("PREVIEW: Unsupported pixel format (%d)", pix_format);
 		return nullptr;
 	}
+	stage_done(PREVIEW_STAGE_STRETCH, start);
 	return img;
 }
 
+static QImage* decode_preview(const char *format, unsigned char *data, unsigned long size) {
+	if (!strcmp(format, ".jpeg") ||
+		!strcmp(format, ".jpg") ||
+		!strcmp(format, ".JPG") ||
+		!strcmp(format, ".JPEG")) {
+		return create_jpeg_preview(data, size);
+	} else if (!strcmp(format, ".fits") ||
+			   !strcmp(format, ".fit") ||
+			   !strcmp(format, ".fts") ||
+			   !strcmp(format, ".FITS") ||
+			   !strcmp(format, ".FIT") ||
+			   !strcmp(format, ".FTS")) {
+		return create_fits_preview(data, size);
+	} else if (!strcmp(format, ".raw") ||
+			   !strcmp(format, ".RAW")) {
+		return create_raw_preview(data, size);
+	}
+	return nullptr;
+}
+
+
+QImage* create_preview(const char *format, unsigned char *data, unsigned long size) {
+	QElapsedTimer timer;
+	timer.start();
+	QImage *image = decode_preview(format, data, size);
+	if (image != nullptr) Stats::instance().decode_time(timer.nsecsElapsed() / 1000000.0);
+	return image;
+}
+
+
 QImage* create_preview(indigo_property *property, indigo_item *item) {
-	QImage *preview = nullptr;
 	if (property->type != INDIGO_BLOB_VECTOR) return nullptr;
 	if ((property->state == INDIGO_OK_STATE) && (item->blob.value != NULL)) {
-		if (!strcmp(item->blob.format, ".jpeg") ||
-			!strcmp(item->blob.format, ".jpg") ||
-			!strcmp(item->blob.format, ".JPG") ||
-			!strcmp(item->blob.format, ".JPEG")) {
-			preview = create_jpeg_preview((unsigned char*)item->blob.value, item->blob.size);
-		} else if (!strcmp(item->blob.format, ".fits") ||
-				   !strcmp(item->blob.format, ".fit") ||
-				   !strcmp(item->blob.format, ".fts") ||
-				   !strcmp(item->blob.format, ".FITS") ||
-				   !strcmp(item->blob.format, ".FIT") ||
-				   !strcmp(item->blob.format, ".FTS")) {
-			preview = create_fits_preview((unsigned char*)item->blob.value, item->blob.size);
-					/* DUMMY TEST CODE */
-					/*
-					  FILE *file;
-					  char *buffer;
-					  unsigned long fileLen;
-					  char name[100] = "fits/m16.fits";
-
-					  file = fopen(name, "rb");
-					  fseek(file, 0, SEEK_END);
-					  fileLen=ftell(file);
-					  fseek(file, 0, SEEK_SET);
-
-					  buffer=(char *)malloc(fileLen+1);
-
-					  fread(buffer, fileLen, 1, file);
-					  fclose(file);
-
-					  preview = create_fits_preview((unsigned char*)buffer, fileLen+1);
-					*/
-		} else if (!strcmp(item->blob.format, ".raw") ||
-				   !strcmp(item->blob.format, ".RAW")) {
-			preview = create_raw_preview((unsigned char*)item->blob.value, item->blob.size);
-		}
+		return create_preview(item->blob.format, (unsigned char*)item->blob.value, item->blob.size);
 	}
-	return preview;
+	return nullptr;
 }
@@ -21,6 +21,7 @@
 
 #include <QImage>
 #include <QHash>
+#include <QList>
 #include <indigo/indigo_client.h>
 
 #if !defined(INDIGO_WINDOWS)
@@ -36,13 +37,54 @@ typedef enum {
 	STRETCH_HARD = 2,
 } preview_stretch;
 
+#define PREVIEW_TILE_SIZE 256
+
+/* Stages reported to the timing callback, set by bench_preview and BlobTrace */
+typedef enum {
+	PREVIEW_STAGE_PARSE = 0,
+	PREVIEW_STAGE_HISTOGRAM,
+	PREVIEW_STAGE_DEBAYER,
+	PREVIEW_STAGE_STRETCH,
+	PREVIEW_STAGE_SCALE,
+	PREVIEW_STAGE_CACHE,
+	PREVIEW_STAGE_COUNT
+} preview_stage;
+
+typedef void (*preview_timing_callback)(preview_stage stage, double ms);
+void set_preview_timing_callback(preview_timing_callback callback);
+
+/* Stretched preview with its mip levels. Each level is half the size of the
+   one before, down to a single tile. The generation changes whenever the
+   pixels do, so views can tell whether their cached tiles are still valid.
+*/
+class preview_image: public QImage {
+public:
+	preview_image(): QImage(), m_generation(0) {
+	};
+	preview_image(const QImage &image);
+
+	int level_count() const { return m_levels.size() + 1; }
+	const QImage& level(int n) const {
+		if (n <= 0 || m_levels.empty()) return *this;
+		return m_levels[qMin(n, m_levels.size()) - 1];
+	}
+	unsigned int generation() const { return m_generation; }
+	void mark(const char *text);
+
+private:
+	QList<QImage> m_levels;
+	unsigned int m_generation;
+};
+
+QString preview_key(const char *device, const char *property, const char *item);
+QImage* create_preview(const char *format, unsigned char *data, unsigned long size);
 QImage* create_jpeg_preview(unsigned char *jpg_buffer, unsigned long jpg_size);
 QImage* create_fits_preview(unsigned char *fits_buffer, unsigned long fits_size);
 QImage* create_raw_preview(unsigned char *raw_image_buffer, unsigned long raw_size);
 QImage* create_preview(int width, int height, int pixel_format, char *image_data, int *hist, double white_threshold);
 QImage* create_preview(indigo_property *property, indigo_item *item);
 
-class blob_preview_cache: QHash<QString, QImage*> {
+class blob_preview_cache: QHash<QString, preview_image*> {
 public:
 	blob_preview_cache(): preview_mutex(PTHREAD_MUTEX_INITIALIZER) {
 	};
@@ -50,7 +92,7 @@ public:
 	~blob_preview_cache() {
 		blob_preview_cache::iterator i;
 		for (i = begin(); i != end(); ++i) {
-			QImage *preview = i.value();
+			preview_image *preview = i.value();
 			if (preview != nullptr) delete(preview);
 		}
 	};
@@ -64,7 +106,9 @@ public:
 	void set_stretch_level(preview_stretch level);
 	bool create(indigo_property *property, indigo_item *item);
 	bool obsolete(indigo_property *property, indigo_item *item);
-	QImage* get(indigo_property *property, indigo_item *item);
+	preview_image* get(indigo_property *property, indigo_item *item);
+	bool copy(indigo_property *property, indigo_item *item, preview_image *preview);
+	void insert_preview(const QString &key, preview_image *preview);
 	bool remove(indigo_property *property, indigo_item *item);
 };
 
@@ -0,0 +1,311 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include "blobrecorder.h"
+#include "blobnaming.h"
+#include "indigoclient.h"
+
+#if defined(INDIGO_WINDOWS)
+#define RECORDER_OPEN_FLAGS (O_CREAT | O_WRONLY | O_EXCL | O_BINARY)
+#define RECORDER_OPEN_MODE 0
+#define fsync _commit
+#else
+#define RECORDER_OPEN_FLAGS (O_CREAT | O_WRONLY | O_EXCL)
+#define RECORDER_OPEN_MODE (S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH)
+#endif
+
+BlobRecorder::BlobRecorder() :
+	m_head(nullptr),
+	m_tail(nullptr),
+	m_queued_bytes(0),
+	m_running(false),
+	m_frames_written(0),
+	m_frames_dropped(0),
+	m_bytes_written(0) {
+	m_directory[0] = '\0';
+	pthread_mutex_init(&m_mutex, nullptr);
+	pthread_cond_init(&m_cond, nullptr);
+}
+
+
+BlobRecorder::~BlobRecorder() {
+	stop();
+	pthread_cond_destroy(&m_cond);
+	pthread_mutex_destroy(&m_mutex);
+}
+
+
+void BlobRecorder::set_directory(const char *directory) {
+	strncpy(m_directory, directory, PATH_LEN);
+	m_directory[PATH_LEN - 1] = '\0';
+}
+
+
+bool BlobRecorder::start() {
+	if (m_running) return true;
+	m_running = true;
+	if (pthread_create(&m_thread, nullptr, writer_thread, this) != 0) {
+		indigo_error("Can not start BLOB writer thread\n");
+		m_running = false;
+		return false;
+	}
+	if (m_directory[0]) indigo_log("Recording BLOBs to '%s'\n", m_directory);
+	return true;
+}
+
+
+/* Everything already queued is written before the thread exits */
+void BlobRecorder::stop() {
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_running = false;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+	pthread_join(m_thread, nullptr);
+	if (m_directory[0]) indigo_log("Recorded %lu BLOBs (%llu bytes), %lu dropped\n", m_frames_written, m_bytes_written, m_frames_dropped);
+}
+
+
+bool BlobRecorder::enqueue(indigo_property *property, indigo_item *item) {
+	return push(m_directory, property, item, false);
+}
+
+
+bool BlobRecorder::save(const char *directory, indigo_property *property, indigo_item *item) {
+	return push(directory, property, item, true);
+}
+
+
+bool BlobRecorder::push(const char *directory, indigo_property *property, indigo_item *item, bool report) {
+	if (item->blob.value == nullptr || item->blob.size <= 0) return false;
+
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		indigo_error("BLOB %s.%s.%s dropped, writer is not running\n", property->device, property->name, item->name);
+		return false;
+	}
+	if (m_queued_bytes + item->blob.size > RECORDER_MAX_QUEUED_BYTES) {
+		m_frames_dropped++;
+		pthread_mutex_unlock(&m_mutex);
+		indigo_error("BLOB %s.%s.%s dropped, writer is behind\n", property->device, property->name, item->name);
+		return false;
+	}
+	m_queued_bytes += item->blob.size;
+	pthread_mutex_unlock(&m_mutex);
+
+	blob_job *job = (blob_job *)malloc(sizeof(blob_job));
+	job->data = malloc(item->blob.size);
+	if (job->data == nullptr) {
+		free(job);
+		pthread_mutex_lock(&m_mutex);
+		m_queued_bytes -= item->blob.size;
+		m_frames_dropped++;
+		pthread_mutex_unlock(&m_mutex);
+		return false;
+	}
+	memcpy(job->data, item->blob.value, item->blob.size);
+	job->size = item->blob.size;
+	job->report = report;
+	job->fd = -1;
+	job->file_name[0] = '\0';
+	job->next = nullptr;
+	strncpy(job->directory, directory, PATH_LEN);
+	strncpy(job->device, property->device, INDIGO_NAME_SIZE);
+	strncpy(job->property, property->name, INDIGO_NAME_SIZE);
+	strncpy(job->item, item->name, INDIGO_NAME_SIZE);
+	strncpy(job->format, item->blob.format, INDIGO_NAME_SIZE);
+
+	pthread_mutex_lock(&m_mutex);
+	if (m_tail) m_tail->next = job;
+	else m_head = job;
+	m_tail = job;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+	return true;
+}
+
+
+void* BlobRecorder::writer_thread(void *arg) {
+	BlobRecorder *recorder = (BlobRecorder *)arg;
+
+	pthread_mutex_lock(&recorder->m_mutex);
+	while (true) {
+		while (recorder->m_head == nullptr && recorder->m_running)
+			pthread_cond_wait(&recorder->m_cond, &recorder->m_mutex);
+		if (recorder->m_head == nullptr) break;
+
+		/* take up to RECORDER_MAX_BATCH jobs and write them without holding the lock */
+		blob_job *batch = recorder->m_head;
+		blob_job *last = batch;
+		long batch_bytes = last->size;
+		for (int count = 1; count < RECORDER_MAX_BATCH && last->next; count++) {
+			last = last->next;
+			batch_bytes += last->size;
+		}
+		recorder->m_head = last->next;
+		if (recorder->m_head == nullptr) recorder->m_tail = nullptr;
+		last->next = nullptr;
+		pthread_mutex_unlock(&recorder->m_mutex);
+
+		recorder->write_batch(batch);
+
+		pthread_mutex_lock(&recorder->m_mutex);
+		recorder->m_queued_bytes -= batch_bytes;
+	}
+	pthread_mutex_unlock(&recorder->m_mutex);
+	return nullptr;
+}
+
+
+static void sync_directory(const char *directory) {
+#if !defined(INDIGO_WINDOWS)
+	int fd = open(directory, O_RDONLY);
+	if (fd >= 0) {
+		fsync(fd);
+		close(fd);
+	}
+#else
+	Q_UNUSED(directory);
+#endif
+}
+
+
+/* With BLOB_SYNC_BATCH the files of a batch stay open until all of them
+   are written and are then synced together, the other policies finish
+   each file as soon as it is written
+*/
+void BlobRecorder::write_batch(blob_job *batch) {
+	blob_sync_policy policy = conf.blob_sync;
+	bool written = false;
+
+	for (blob_job *job = batch; job; job = job->next) {
+		if (!write_job(job)) {
+			report(job, false);
+			continue;
+		}
+		written = true;
+		if (policy != BLOB_SYNC_BATCH) finish_job(job, policy == BLOB_SYNC_FILE);
+	}
+
+	for (blob_job *job = batch; job; job = job->next) {
+		if (job->fd >= 0) finish_job(job, true);
+	}
+
+	/* new directory entries have to be durable too */
+	if (written && policy != BLOB_SYNC_NONE) {
+		const char *directory = nullptr;
+		for (blob_job *job = batch; job; job = job->next) {
+			if (directory == nullptr || strcmp(directory, job->directory)) {
+				directory = job->directory;
+				sync_directory(directory);
+			}
+		}
+	}
+
+	while (batch) {
+		blob_job *next = batch->next;
+		free(batch->data);
+		free(batch);
+		batch = next;
+	}
+}
+
+
+bool BlobRecorder::write_job(blob_job *job) {
+	int fd;
+
+	/* sequence numbers only grow, an existing file is skipped, never overwritten */
+	int tries = 0;
+	do {
+		BlobFileNamer::instance().make_name(job->directory, job->device, job->property, job->item, job->format, job->file_name, sizeof(job->file_name));
+		fd = open(job->file_name, RECORDER_OPEN_FLAGS, RECORDER_OPEN_MODE);
+	} while (fd < 0 && errno == EEXIST && ++tries < BLOB_NAME_MAX_TRIES);
+
+	if (fd < 0) {
+		indigo_error("Dropping BLOB %s.%s.%s (%ld bytes), can not create '%s': %s\n", job->device, job->property, job->item, job->size, job->file_name, strerror(errno));
+		return false;
+	}
+
+#if defined(INDIGO_LINUX)
+	/* reserve the extent up front so the filesystem allocates it contiguously */
+	posix_fallocate(fd, 0, job->size);
+#endif
+
+	const char *data = (const char *)job->data;
+	long remaining = job->size;
+	while (remaining > 0) {
+		ssize_t res = write(fd, data, remaining);
+		if (res < 0) {
+			if (errno == EINTR) continue;
+			indigo_error("Can not write '%s': %s\n", job->file_name, strerror(errno));
+			close(fd);
+			return false;
+		}
+		data += res;
+		remaining -= res;
+	}
+	job->fd = fd;
+	return true;
+}
+
+
+/* Closes a written file and accounts for it */
+void BlobRecorder::finish_job(blob_job *job, bool sync) {
+	bool success = true;
+	if (sync && fsync(job->fd) != 0) {
+		indigo_error("Can not sync '%s': %s\n", job->file_name, strerror(errno));
+		success = false;
+	}
+#if defined(INDIGO_LINUX)
+	/* saved data is not read back, keep the page cache for the previews */
+	posix_fadvise(job->fd, 0, 0, POSIX_FADV_DONTNEED);
+#endif
+	close(job->fd);
+	job->fd = -1;
+
+	if (success) {
+		m_frames_written++;
+		m_bytes_written += job->size;
+		indigo_debug("BLOB written to '%s' (%ld bytes)\n", job->file_name, job->size);
+	}
+	report(job, success);
+}
+
+
+void BlobRecorder::report(blob_job *job, bool success) {
+	if (!job->report) return;
+
+	/* Goes through the client message signal, the receiver frees it */
+	char *message = (char *)malloc(INDIGO_VALUE_SIZE);
+	if (success)
+		snprintf(message, INDIGO_VALUE_SIZE, "Image saved to '%s'", job->file_name);
+	else
+		snprintf(message, INDIGO_VALUE_SIZE, "Can not save '%s'", job->file_name);
+	emit(IndigoClient::instance().message_sent(nullptr, message));
+}
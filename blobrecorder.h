@@ -0,0 +1,102 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef BLOBRECORDER_H
+#define BLOBRECORDER_H
+
+#include <pthread.h>
+#include <indigo/indigo_bus.h>
+#include "conf.h"
+
+/* Frames waiting to be written are dropped above this, the indigo
+   threads never wait for the disk
+*/
+#define RECORDER_MAX_QUEUED_BYTES (1024L * 1024L * 1024L)
+
+/* Files kept open at once while a batch waits for its fsync */
+#define RECORDER_MAX_BATCH 32
+
+struct blob_job {
+	char directory[PATH_LEN];
+	char device[INDIGO_NAME_SIZE];
+	char property[INDIGO_NAME_SIZE];
+	char item[INDIGO_NAME_SIZE];
+	char format[INDIGO_NAME_SIZE];
+	void *data;
+	long size;
+	bool report;
+	int fd;
+	char file_name[PATH_LEN];
+	blob_job *next;
+};
+
+
+/* Writes BLOBs from its own thread. enqueue() (recording) and save() (user
+   request) copy the BLOB on the calling thread and return immediately. The
+   writer thread takes everything queued as one batch, preallocates and
+   writes each file and syncs according to conf.blob_sync. Saves are
+   reported to the message log when done.
+*/
+class BlobRecorder {
+public:
+	static BlobRecorder& instance();
+	~BlobRecorder();
+
+	void set_directory(const char *directory);
+	bool start();
+	void stop();
+	bool running() const { return m_running; }
+	bool enqueue(indigo_property *property, indigo_item *item);
+	bool save(const char *directory, indigo_property *property, indigo_item *item);
+
+	unsigned long frames_written() const { return m_frames_written; }
+	unsigned long frames_dropped() const { return m_frames_dropped; }
+	unsigned long long bytes_written() const { return m_bytes_written; }
+
+private:
+	BlobRecorder();
+
+	static void* writer_thread(void *arg);
+	bool push(const char *directory, indigo_property *property, indigo_item *item, bool report);
+	void write_batch(blob_job *batch);
+	bool write_job(blob_job *job);
+	void finish_job(blob_job *job, bool sync);
+	void report(blob_job *job, bool success);
+
+	char m_directory[PATH_LEN];
+	pthread_t m_thread;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	blob_job *m_head;
+	blob_job *m_tail;
+	long m_queued_bytes;
+	bool m_running;
+
+	unsigned long m_frames_written;
+	unsigned long m_frames_dropped;
+	unsigned long long m_bytes_written;
+};
+
+inline BlobRecorder& BlobRecorder::instance() {
+	static BlobRecorder* me = nullptr;
+	if (!me) me = new BlobRecorder();
+	return *me;
+}
+
+#endif // BLOBRECORDER_H
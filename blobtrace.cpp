@@ -0,0 +1,205 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <stdio.h>
+#include <math.h>
+#include <algorithm>
+#include <QAtomicInt>
+#include "blobtrace.h"
+
+static const char *stage_names[BLOB_TRACE_COUNT] = {
+	"receive", "download", "queue", "parse", "histogram", "debayer", "stretch", "scale", "cache", "paint", "total"
+};
+
+/* Frame a preview thread is working on, preview stages are charged to it */
+static thread_local unsigned long current_frame = 0;
+static thread_local QString current_key;
+static thread_local int current_thread = 0;
+static QAtomicInt thread_count;
+
+
+static int thread_number() {
+	if (current_thread == 0) current_thread = thread_count.fetchAndAddRelaxed(1) + 1;
+	return current_thread;
+}
+
+
+BlobTrace::BlobTrace() : m_enabled(false), m_next_span(0), m_next_frame(1) {
+	pthread_mutex_init(&m_mutex, nullptr);
+	m_clock.start();
+}
+
+
+const char* BlobTrace::stage_name(blob_trace_stage stage) {
+	return stage_names[stage];
+}
+
+
+void BlobTrace::set_enabled(bool enabled) {
+	m_enabled = enabled;
+	set_preview_timing_callback(enabled ? preview_stage_done : nullptr);
+}
+
+
+unsigned long BlobTrace::begin_frame(const QString &key, qint64 received_us, qint64 download_us) {
+	qint64 now = now_us();
+	pthread_mutex_lock(&m_mutex);
+	trace_frame &frame = m_frames[key];
+	frame.id = m_next_frame++;
+	frame.received_us = received_us;
+	frame.queued_us = now;
+	frame.painted = false;
+	unsigned long id = frame.id;
+	pthread_mutex_unlock(&m_mutex);
+
+	if (download_us) add_span(BLOB_TRACE_DOWNLOAD, id, download_us, now, key);
+	add_span(BLOB_TRACE_RECEIVE, id, received_us, now, key);
+	return id;
+}
+
+
+void BlobTrace::dequeue(const QString &key) {
+	qint64 now = now_us();
+	pthread_mutex_lock(&m_mutex);
+	auto frame = m_frames.constFind(key);
+	if (frame == m_frames.constEnd()) {
+		pthread_mutex_unlock(&m_mutex);
+		current_frame = 0;
+		return;
+	}
+	unsigned long id = frame->id;
+	qint64 queued_us = frame->queued_us;
+	pthread_mutex_unlock(&m_mutex);
+
+	current_frame = id;
+	current_key = key;
+	add_span(BLOB_TRACE_QUEUE, id, queued_us, now, key);
+}
+
+
+/* Repaints of a frame already shown count as paint but not again as total */
+void BlobTrace::painted(const QString &key, qint64 begin_us) {
+	qint64 now = now_us();
+	pthread_mutex_lock(&m_mutex);
+	auto frame = m_frames.find(key);
+	if (frame == m_frames.end()) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	unsigned long id = frame->id;
+	qint64 received_us = frame->received_us;
+	bool first = !frame->painted;
+	frame->painted = true;
+	pthread_mutex_unlock(&m_mutex);
+
+	add_span(BLOB_TRACE_PAINT, id, begin_us, now, key);
+	if (first) add_span(BLOB_TRACE_TOTAL, id, received_us, now, key);
+}
+
+
+void BlobTrace::preview_stage_done(preview_stage stage, double ms) {
+	if (current_frame == 0) return;
+	BlobTrace &trace = BlobTrace::instance();
+	qint64 now = trace.now_us();
+	trace.add_span((blob_trace_stage)(BLOB_TRACE_PARSE + stage), current_frame, now - (qint64)(ms * 1000), now, current_key);
+	/* the cache insert is the last stage of a frame */
+	if (stage == PREVIEW_STAGE_CACHE) current_frame = 0;
+}
+
+
+void BlobTrace::add_span(blob_trace_stage stage, unsigned long frame, qint64 begin_us, qint64 end_us, const QString &key) {
+	if (!m_enabled) return;
+	blob_trace_span span = { stage, frame, thread_number(), begin_us, end_us - begin_us, key };
+	pthread_mutex_lock(&m_mutex);
+	if (m_spans.size() < BLOB_TRACE_MAX_SPANS) {
+		m_spans.append(span);
+	} else {
+		m_spans[m_next_span] = span;
+	}
+	m_next_span = (m_next_span + 1) % BLOB_TRACE_MAX_SPANS;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void BlobTrace::clear() {
+	pthread_mutex_lock(&m_mutex);
+	m_spans.clear();
+	m_frames.clear();
+	m_next_span = 0;
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+static double percentile(const QVector<qint64> &sorted, double p) {
+	if (sorted.isEmpty()) return 0;
+	int index = (int)ceil(p * sorted.size()) - 1;
+	return sorted[qBound(0, index, sorted.size() - 1)] / 1000.0;
+}
+
+
+QList<blob_trace_summary> BlobTrace::summary() {
+	QVector<qint64> durations[BLOB_TRACE_COUNT];
+	pthread_mutex_lock(&m_mutex);
+	for (const blob_trace_span &span : m_spans) durations[span.stage].append(span.duration_us);
+	pthread_mutex_unlock(&m_mutex);
+
+	QList<blob_trace_summary> result;
+	for (int stage = 0; stage < BLOB_TRACE_COUNT; stage++) {
+		QVector<qint64> &sorted = durations[stage];
+		std::sort(sorted.begin(), sorted.end());
+		blob_trace_summary summary = {
+			(blob_trace_stage)stage,
+			sorted.size(),
+			percentile(sorted, 0.50),
+			percentile(sorted, 0.95),
+			percentile(sorted, 0.99),
+			sorted.isEmpty() ? 0 : sorted.last() / 1000.0
+		};
+		result.append(summary);
+	}
+	return result;
+}
+
+
+/* Chrome trace-event format, loads in chrome://tracing and Perfetto */
+bool BlobTrace::export_chrome(const QString &path) {
+	FILE *file = fopen(path.toUtf8().constData(), "w");
+	if (file == nullptr) {
+		indigo_error("Can not create trace file '%s'\n", path.toUtf8().constData());
+		return false;
+	}
+	pthread_mutex_lock(&m_mutex);
+	QVector<blob_trace_span> spans = m_spans;
+	pthread_mutex_unlock(&m_mutex);
+	std::sort(spans.begin(), spans.end(), [](const blob_trace_span &a, const blob_trace_span &b) {
+		return a.begin_us < b.begin_us;
+	});
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	for (int i = 0; i < spans.size(); i++) {
+		const blob_trace_span &span = spans[i];
+		QByteArray key = span.key.toUtf8().replace('\\', "\\\\").replace('"', "\\\"");
+		fprintf(file, "{\"name\":\"%s\",\"cat\":\"blob\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"args\":{\"frame\":%lu,\"key\":\"%s\"}}%s\n",
+			stage_names[span.stage], span.thread, (long long)span.begin_us, (long long)span.duration_us, span.frame, key.constData(), i < spans.size() - 1 ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
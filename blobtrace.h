@@ -0,0 +1,128 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef BLOBTRACE_H
+#define BLOBTRACE_H
+
+#include <pthread.h>
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QElapsedTimer>
+#include <indigo/indigo_bus.h>
+#include "blobpreview.h"
+
+/* Spans kept, the oldest are overwritten */
+#define BLOB_TRACE_MAX_SPANS 65536
+
+/* The preview stages map one to one onto PREVIEW_STAGE_* */
+typedef enum {
+	BLOB_TRACE_RECEIVE = 0,
+	BLOB_TRACE_DOWNLOAD,
+	BLOB_TRACE_QUEUE,
+	BLOB_TRACE_PARSE,
+	BLOB_TRACE_HISTOGRAM,
+	BLOB_TRACE_DEBAYER,
+	BLOB_TRACE_STRETCH,
+	BLOB_TRACE_SCALE,
+	BLOB_TRACE_CACHE,
+	BLOB_TRACE_PAINT,
+	BLOB_TRACE_TOTAL,
+	BLOB_TRACE_COUNT
+} blob_trace_stage;
+
+struct blob_trace_span {
+	blob_trace_stage stage;
+	unsigned long frame;
+	int thread;
+	qint64 begin_us;
+	qint64 duration_us;
+	QString key;
+};
+
+struct blob_trace_summary {
+	blob_trace_stage stage;
+	int count;
+	double p50_ms;
+	double p95_ms;
+	double p99_ms;
+	double max_ms;
+};
+
+
+/* Follows each BLOB from the update callback to the widget showing it.
+   Frames are identified by their preview key, the key remembers the newest
+   frame, its arrival and the time it was queued for the preview. The
+   preview stages come through the blobpreview timing callback and are
+   attributed to the frame the calling thread has dequeued.
+
+   Nothing is recorded unless tracing is enabled, the disabled check is a
+   plain flag read.
+*/
+class BlobTrace {
+public:
+	static BlobTrace& instance();
+
+	void set_enabled(bool enabled);
+	bool enabled() const { return m_enabled; }
+	qint64 now_us() const { return m_clock.nsecsElapsed() / 1000; }
+
+	/* indigo thread: the frame was received at received_us and is queued now */
+	unsigned long begin_frame(const QString &key, qint64 received_us, qint64 download_us);
+	/* preview thread: the frame of key is picked up, preview stages follow */
+	void dequeue(const QString &key);
+	/* GUI thread: the widget of key has shown its frame */
+	void painted(const QString &key, qint64 begin_us);
+
+	void clear();
+	QList<blob_trace_summary> summary();
+	bool export_chrome(const QString &path);
+
+	static const char* stage_name(blob_trace_stage stage);
+
+private:
+	struct trace_frame {
+		unsigned long id;
+		qint64 received_us;
+		qint64 queued_us;
+		bool painted;
+	};
+
+	BlobTrace();
+
+	static void preview_stage_done(preview_stage stage, double ms);
+	void add_span(blob_trace_stage stage, unsigned long frame, qint64 begin_us, qint64 end_us, const QString &key);
+
+	bool m_enabled;
+	QElapsedTimer m_clock;
+	pthread_mutex_t m_mutex;
+	QHash<QString, trace_frame> m_frames;
+	QVector<blob_trace_span> m_spans;
+	int m_next_span;
+	unsigned long m_next_frame;
+};
+
+inline BlobTrace& BlobTrace::instance() {
+	static BlobTrace* me = nullptr;
+	if (!me) me = new BlobTrace();
+	return *me;
+}
+
+#endif // BLOBTRACE_H
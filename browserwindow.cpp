@@ -23,11 +23,16 @@
 #include <QTreeView>
 #include <QMenuBar>
 #include <QIcon>
-#include <QPlainTextEdit>
+#include <QListView>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QScrollBar>
 #include <QScrollArea>
+#include <QStackedWidget>
 #include <QMessageBox>
 #include <QActionGroup>
 #include <QFileDialog>
+#include <QTimer>
 #include <sys/time.h>
 #include "browserwindow.h"
 #include "qservicemodel.h"
@@ -37,10 +42,24 @@
 #include "qindigoservers.h"
 #include "blobpreview.h"
 #include "logger.h"
+#include "logmodel.h"
+#include "blobrecorder.h"
+#include "blobnaming.h"
+#include "livepreview.h"
+#include "replayserver.h"
+#include "sessionarchive.h"
+#include "blobtrace.h"
+#include "qblobtrace.h"
+#include "qdiagnostics.h"
+#include "qwatchlist.h"
+#include "stats.h"
+#include "propertyindex.h"
 #include "conf.h"
 #include "version.h"
 
 void write_conf();
+QString archive_directory();
+void startup_trace(const char *phase);
 
 BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	setWindowTitle(tr("INDIGO Control Panel"));
@@ -57,6 +76,8 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 
 	current_path = new SelectionPath();
 	mIndigoServers = new QIndigoServers(this);
+	mBlobTrace = new QBlobTrace(this);
+	mDiagnostics = new QDiagnostics(this);
 
 	//  Set central widget of window
 	QWidget *central = new QWidget;
@@ -70,8 +91,18 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	central->setLayout(rootLayout);
 
 	//  Create log viewer
-	mLog = new QPlainTextEdit;
-	mLog->setReadOnly(true);
+	mLogModel = new LogModel(conf.log_max_lines);
+	mLog = new QListView;
+	mLog->setModel(mLogModel);
+	mLog->setUniformItemSizes(true);
+	mLog->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	mLog->setSelectionMode(QAbstractItemView::NoSelection);
+	m_log_follow = true;
+	m_filter_active = false;
+
+	// Follow the tail unless the user has scrolled up to read older lines
+	connect(mLogModel, &LogModel::rowsAboutToBeInserted, this, &BrowserWindow::on_log_about_to_grow);
+	connect(mLogModel, &LogModel::rowsInserted, this, &BrowserWindow::on_log_grown);
 
 	// Create menubar
 	QMenuBar *menu_bar = new QMenuBar;
@@ -104,7 +135,7 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 
 	menu = new QMenu("&Edit");
 	act = menu->addAction(tr("Clear &messages"));
-	connect(act, &QAction::triggered, mLog, &QPlainTextEdit::clear);
+	connect(act, &QAction::triggered, mLogModel, &LogModel::clear);
 	menu_bar->addMenu(menu);
 
 	menu = new QMenu("&Settings");
@@ -124,6 +155,16 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	act->setChecked(conf.indigo_use_host_suffix);
 	connect(act, &QAction::toggled, this, &BrowserWindow::on_use_suffix_changed);
 
+	act = menu->addAction(tr("&Live BLOB preview (drop frames)"));
+	act->setCheckable(true);
+	act->setChecked(conf.live_preview);
+	connect(act, &QAction::toggled, this, &BrowserWindow::on_live_preview_changed);
+
+	act = menu->addAction(tr("&Archive property history"));
+	act->setCheckable(true);
+	act->setChecked(conf.archive_history == ARCHIVE_HISTORY_ON);
+	connect(act, &QAction::toggled, this, &BrowserWindow::on_archive_history_changed);
+
 	act = menu->addAction(tr("Use property state &icons"));
 	act->setCheckable(true);
 	act->setChecked(conf.use_state_icons);
@@ -156,6 +197,28 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	connect(act, &QAction::triggered, this, &BrowserWindow::on_hard_stretch);
 	stretch_group->addAction(act);
 
+	menu->addSeparator();
+	QActionGroup *refresh_group = new QActionGroup(this);
+	refresh_group->setExclusive(true);
+
+	act = menu->addAction("Tree Refresh Rate: &60 fps");
+	act->setCheckable(true);
+	if (conf.tree_refresh_ms == TREE_REFRESH_FAST_MS) act->setChecked(true);
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_fast_refresh);
+	refresh_group->addAction(act);
+
+	act = menu->addAction("Tree Refresh Rate: &30 fps");
+	act->setCheckable(true);
+	if (conf.tree_refresh_ms == TREE_REFRESH_NORMAL_MS) act->setChecked(true);
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_normal_refresh);
+	refresh_group->addAction(act);
+
+	act = menu->addAction("Tree Refresh Rate: &5 fps (low power)");
+	act->setCheckable(true);
+	if (conf.tree_refresh_ms == TREE_REFRESH_LOW_POWER_MS) act->setChecked(true);
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_low_power_refresh);
+	refresh_group->addAction(act);
+
 	menu->addSeparator();
 	QActionGroup *log_group = new QActionGroup(this);
 	log_group->setExclusive(true);
@@ -184,6 +247,59 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	connect(act, &QAction::triggered, this, &BrowserWindow::on_log_trace);
 	log_group->addAction(act);
 
+	act = menu->addAction(tr("Message &History Size..."));
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_log_size_act);
+
+	act = menu->addAction(tr("Saved BLOB File &Names..."));
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_blob_name_template_act);
+
+	menu->addSeparator();
+	QActionGroup *sync_group = new QActionGroup(this);
+	sync_group->setExclusive(true);
+
+	act = menu->addAction("Saved BLOBs: &No Sync");
+	act->setCheckable(true);
+	if (conf.blob_sync == BLOB_SYNC_NONE) act->setChecked(true);
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_blob_sync_none);
+	sync_group->addAction(act);
+
+	act = menu->addAction("Saved BLOBs: Sync Each &File");
+	act->setCheckable(true);
+	if (conf.blob_sync == BLOB_SYNC_FILE) act->setChecked(true);
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_blob_sync_file);
+	sync_group->addAction(act);
+
+	act = menu->addAction("Saved BLOBs: Sync Each &Batch");
+	act->setCheckable(true);
+	if (conf.blob_sync == BLOB_SYNC_BATCH) act->setChecked(true);
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_blob_sync_batch);
+	sync_group->addAction(act);
+
+	menu_bar->addMenu(menu);
+
+	menu = new QMenu("&Tools");
+
+	act = menu->addAction(tr("&Pin/Unpin Selected Property"));
+	act->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_P));
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_pin_act);
+
+	act = menu->addAction(tr("&Watch List..."));
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_watch_list_act);
+
+	menu->addSeparator();
+
+	act = menu->addAction(tr("&Trace BLOB Latency"));
+	act->setCheckable(true);
+	act->setChecked(BlobTrace::instance().enabled());
+	connect(act, &QAction::toggled, this, &BrowserWindow::on_blob_trace_changed);
+
+	act = menu->addAction(tr("BLOB &Latency..."));
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_blob_trace_act);
+
+	menu->addSeparator();
+
+	act = menu->addAction(tr("&Diagnostics..."));
+	connect(act, &QAction::triggered, this, &BrowserWindow::on_diagnostics_act);
 	menu_bar->addMenu(menu);
 
 	menu = new QMenu("&Help");
@@ -217,6 +333,11 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	selection_layout->setContentsMargins(0, 0, 1, 0);
 	//selection_layout->setMargin(0);
 	selection_panel->setLayout(selection_layout);
+
+	mFilter = new QLineEdit();
+	mFilter->setPlaceholderText("Filter devices, groups, properties and items");
+	mFilter->setClearButtonEnabled(true);
+	selection_layout->addWidget(mFilter);
 	selection_layout->addWidget(mProperties);
 
 	mSelectionLine = new QLabel();
@@ -232,6 +353,12 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	mFormLayout->addWidget(mScrollArea);
 	mScrollArea->setMinimumWidth(PROPERTY_AREA_MIN_WIDTH);
 
+	//  Forms are switched in the stack so they are never reparented (and re-polished)
+	mFormStack = new QStackedWidget();
+	mEmptyForm = new QWidget();
+	mFormStack->addWidget(mEmptyForm);
+	mScrollArea->setWidget(mFormStack);
+
 	QSplitter* hSplitter = new QSplitter;
 	hSplitter->addWidget(selection_panel);
 	hSplitter->addWidget(form_panel);
@@ -249,9 +376,14 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 	mProperties->setHeaderHidden(true);
 	mProperties->setModel(mPropertyModel);
 
+	mWatchList = new QWatchList(mPropertyModel, this);
+	mWatchList->load();
+
 	connect(mServiceModel, &QServiceModel::serviceAdded, mIndigoServers, &QIndigoServers::onAddService);
 	connect(mServiceModel, &QServiceModel::serviceRemoved, mIndigoServers, &QIndigoServers::onRemoveService);
 	connect(mServiceModel, &QServiceModel::serviceConnectionChange, mIndigoServers, &QIndigoServers::onConnectionChange);
+	connect(mServiceModel, &QServiceModel::serviceConnecting, mIndigoServers, &QIndigoServers::onConnecting);
+	connect(mServiceModel, &QServiceModel::serviceConnectFailed, mIndigoServers, &QIndigoServers::onConnectFailed);
 
 	connect(mIndigoServers, &QIndigoServers::requestConnect, mServiceModel, &QServiceModel::onRequestConnect);
 	connect(mIndigoServers, &QIndigoServers::requestDisconnect, mServiceModel, &QServiceModel::onRequestDisconnect);
@@ -274,6 +406,11 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 
 	connect(mPropertyModel, &PropertyModel::property_defined, this, &BrowserWindow::on_property_define);
 	connect(mPropertyModel, &PropertyModel::property_deleted, this, &BrowserWindow::on_property_delete);
+	connect(mPropertyModel, &PropertyModel::node_removed, this, &BrowserWindow::on_node_removed);
+	connect(mPropertyModel, &PropertyModel::property_defined, mWatchList, &QWatchList::on_property_define);
+	connect(mPropertyModel, &PropertyModel::property_deleted, mWatchList, &QWatchList::on_property_delete);
+	connect(mPropertyModel, &PropertyModel::search_index_changed, this, &BrowserWindow::refilter);
+	connect(mFilter, &QLineEdit::textChanged, this, &BrowserWindow::apply_filter);
 
 	connect(&Logger::instance(), &Logger::do_log, this, &BrowserWindow::on_window_log);
 
@@ -283,18 +420,50 @@ BrowserWindow::BrowserWindow(QWidget *parent) : QMainWindow(parent) {
 
 	preview_cache.set_stretch_level(conf.preview_stretch_level);
 
+	// Client, discovery and manual services are started once the window is up
+	m_first_property_seen = false;
+	QTimer::singleShot(0, this, &BrowserWindow::start_session);
+	startup_trace("window built");
+}
+
+
+void BrowserWindow::start_session() {
+	startup_trace("event loop running");
+
+	// Replayed traffic stands in for the servers, nothing is started on the network
+	if (ReplayServer::instance().loaded()) {
+		IndigoClient::instance().enable_blobs(false);
+		IndigoClient::instance().enable_live_preview(conf.live_preview);
+		BlobRecorder::instance().start();
+		LivePreview::instance().start();
+		ReplayServer::instance().start();
+		startup_trace("replay started");
+		return;
+	}
+
 	//  Start up the client
 	IndigoClient::instance().enable_blobs(conf.blobs_enabled);
+	IndigoClient::instance().enable_live_preview(conf.live_preview);
 	IndigoClient::instance().start("INDIGO Control Panel");
+	BlobRecorder::instance().start();
+	LivePreview::instance().start();
+	if (conf.archive_history == ARCHIVE_HISTORY_ON) SessionArchive::instance().start(archive_directory().toUtf8().constData());
+	startup_trace("client started");
+
+	// Connections are not waited for, discovered and manual services connect in parallel
+	mServiceModel->start();
+	startup_trace("discovery started");
 
 	// load manually configured services
 	mServiceModel->loadManualServices();
+	startup_trace("manual services loaded");
 }
 
 
 BrowserWindow::~BrowserWindow () {
 	indigo_debug("CALLED: %s\n", __FUNCTION__);
 	delete mLog;
+	delete mLogModel;
 	delete mProperties;
 	delete mSelectionLine;
 	delete mFormLayout;
@@ -304,7 +473,92 @@ BrowserWindow::~BrowserWindow () {
 	delete current_path;
 }
 
+/* Only rows whose state changes are touched, the matching is done by the index */
+void BrowserWindow::set_filter_hidden(const QPersistentModelIndex &row, bool hide) {
+	if (!row.isValid()) return;
+	if (mProperties->isRowHidden(row.row(), row.parent()) != hide) mProperties->setRowHidden(row.row(), row.parent(), hide);
+}
+
+
+void BrowserWindow::set_filter_match(int id, bool matched) {
+	const PropertyIndex::rows &rows = mPropertyModel->search_index().rows_of(id);
+	set_filter_hidden(rows.property, !matched);
+	const QPersistentModelIndex *parents[] = { &rows.group, &rows.device };
+	for (const QPersistentModelIndex *parent : parents) {
+		int &count = m_filter_parents[*parent];
+		if (matched) {
+			if (count++ == 0) set_filter_hidden(*parent, false);
+		} else if (--count <= 0) {
+			m_filter_parents.remove(*parent);
+			set_filter_hidden(*parent, true);
+		}
+	}
+}
+
+
+/* Typing only changes the rows of the properties that started or stopped
+   matching. Everything is looked at again only when the filter is turned
+   on or off and after the index has changed, see refilter().
+*/
+void BrowserWindow::apply_filter() {
+	QString query = mFilter->text().trimmed();
+	if (query.isEmpty() || !m_filter_active) {
+		refilter();
+		return;
+	}
+
+	QSet<int> matched = mPropertyModel->search_index().match(query);
+	//  Shown first, so parents that stay visible are not hidden meanwhile
+	for (int id : matched) {
+		if (!m_filter_matched.contains(id)) set_filter_match(id, true);
+	}
+	for (int id : m_filter_matched) {
+		if (!matched.contains(id)) set_filter_match(id, false);
+	}
+	m_filter_matched.swap(matched);
+	expand_filter_matches();
+}
+
+
+void BrowserWindow::refilter() {
+	const PropertyIndex &index = mPropertyModel->search_index();
+	QString query = mFilter->text().trimmed();
+	//  Nothing is hidden without a filter, new rows are visible anyway
+	if (query.isEmpty() && !m_filter_active) return;
+	QList<int> ids = index.ids();
+
+	m_filter_active = !query.isEmpty();
+	m_filter_matched = m_filter_active ? index.match(query) : QSet<int>();
+	m_filter_parents.clear();
+	for (int id : ids) {
+		const PropertyIndex::rows &rows = index.rows_of(id);
+		bool matched = !m_filter_active || m_filter_matched.contains(id);
+		set_filter_hidden(rows.property, !matched);
+		if (m_filter_active && matched) {
+			m_filter_parents[rows.group]++;
+			m_filter_parents[rows.device]++;
+		}
+	}
+	for (int id : ids) {
+		const PropertyIndex::rows &rows = index.rows_of(id);
+		set_filter_hidden(rows.group, m_filter_active && !m_filter_parents.contains(rows.group));
+		set_filter_hidden(rows.device, m_filter_active && !m_filter_parents.contains(rows.device));
+	}
+	expand_filter_matches();
+}
+
+
+void BrowserWindow::expand_filter_matches() {
+	if (!m_filter_active || m_filter_parents.size() > FILTER_EXPAND_MAX) return;
+	for (auto i = m_filter_parents.constBegin(); i != m_filter_parents.constEnd(); ++i) {
+		if (i.key().isValid()) mProperties->expand(i.key());
+	}
+}
+
+
 void BrowserWindow::on_create_preview(indigo_property *property, indigo_item *item){
+	if (BlobTrace::instance().enabled())
+		BlobTrace::instance().dequeue(preview_key(property->device, property->name, item->name));
 	preview_cache.create(property, item);
 }
 
@@ -314,6 +568,7 @@ void BrowserWindow::on_obsolete_preview(indigo_property *property, indigo_item *
 
 void BrowserWindow::on_remove_preview(indigo_property *property, indigo_item *item){
 	preview_cache.remove(property, item);
+	LivePreview::instance().remove(preview_key(property->device, property->name, item->name));
 }
 
 void BrowserWindow::on_message_sent(indigo_property* property, char *message) {
@@ -322,60 +577,66 @@ void BrowserWindow::on_message_sent(indigo_property* property, char *message) {
 }
 
 void BrowserWindow::on_window_log(indigo_property* property, char *message) {
-	char timestamp[16];
-	char log_line[512];
-	char message_line[512];
-	struct timeval tmnow;
-
 	if (!message) return;
 
-	gettimeofday(&tmnow, NULL);
-#if defined(INDIGO_WINDOWS)
-	struct tm *lt;
-	time_t rawtime;
-	lt = localtime((const time_t *) &(tmnow.tv_sec));
-	if (lt == NULL) {
-		time(&rawtime);
-		lt = localtime(&rawtime);
-	}
-	strftime(timestamp, sizeof(log_line), "%H:%M:%S", lt);
-#else
-	strftime(timestamp, sizeof(log_line), "%H:%M:%S", localtime((const time_t *) &tmnow.tv_sec));
-#endif
-	snprintf(timestamp + 8, sizeof(timestamp) - 8, ".%03ld", tmnow.tv_usec/1000);
-
 	if (property) {
-		snprintf(message_line, 512, "%s.%s: %s", property->device, property->name, message);
-		switch (property->state) {
-		case INDIGO_ALERT_STATE:
-			snprintf(log_line, 512, "<font color = \"#E00000\">%s %s<\font>", timestamp, message_line);
-			break;
-		case INDIGO_BUSY_STATE:
-			snprintf(log_line, 512, "<font color = \"orange\">%s %s<\font>", timestamp, message_line);
-			break;
-		default:
-			snprintf(log_line, 512, "%s %s", timestamp, message_line);
-			break;
-		}
-		indigo_debug("[message] %s\n", message_line);
+		indigo_debug("[message] %s.%s: %s\n", property->device, property->name, message);
 	} else {
-		snprintf(log_line, 512, "%s %s", timestamp, message);
 		indigo_debug("[message] %s\n", message);
 	}
-	mLog->appendHtml(log_line); // Adds the message to the widget
+	mLogModel->append(property, message);
+}
+
+
+void BrowserWindow::on_log_about_to_grow() {
+	QScrollBar *bar = mLog->verticalScrollBar();
+	m_log_follow = (bar->value() == bar->maximum());
+}
+
+
+void BrowserWindow::on_log_grown() {
+	if (m_log_follow) mLog->scrollToBottom();
 }
 
 void BrowserWindow::on_property_define(indigo_property* property, char *message) {
+	if (!m_first_property_seen) {
+		m_first_property_seen = true;
+		startup_trace("first property defined");
+	}
 	property_define_delete(property, message, false);
 }
 
 void BrowserWindow::on_property_delete(indigo_property* property, char *message) {
+	//  Group and device deletes do not list their BLOBs, streams of the device
+	//  still in use come back with their next frame
+	if (property->name[0] == '\0') LivePreview::instance().remove_device(property->device);
 	property_define_delete(property, message, true);
 }
 
+
+void BrowserWindow::on_node_removed(TreeNode* node) {
+	//  The selection must not outlive the node it points to or its parents
+	for (TreeNode *n = current_path->node; n != nullptr; n = n->parent()) {
+		if (n == node) {
+			indigo_debug("SELECTED NODE removed\n");
+			current_path->ClearSelection();
+			clear_window();
+			return;
+		}
+	}
+}
+
+
 void BrowserWindow::property_define_delete(indigo_property* property, char *message, bool action_deleted) {
 	Q_UNUSED(message);
 
+	//  Cached forms of the group (or of the whole device) are stale now
+	if (property->group[0] == '\0') {
+		invalidate_forms(property->device, nullptr);
+	} else {
+		invalidate_forms(property->device, property->group);
+	}
+
 	if (current_path->type == TREE_NODE_ROOT) return;
 
 	if (current_path->type == TREE_NODE_PROPERTY) {
@@ -422,17 +683,85 @@ void BrowserWindow::property_define_delete(indigo_property* property, char *mess
 void BrowserWindow::clear_window() {
 	indigo_debug("CLEAR_WINDOW!\n");
 	mSelectionLine->setText("");
-	delete mScrollArea;
+	show_form(mEmptyForm);
+}
 
-	mScrollArea = new QScrollArea();
-	mScrollArea->setObjectName("PROPERTY_AREA");
-	mScrollArea->setWidgetResizable(true);
-	mScrollArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
-	mScrollArea->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
-	mFormLayout->addWidget(mScrollArea);
-	mScrollArea->setMinimumWidth(600);
+
+static QString form_key(const char *device, const char *group, const char *property) {
+	QString key(device);
+	key.append("\n");
+	key.append(group);
+	key.append("\n");
+	key.append(property);
+	return key;
 }
 
+
+void BrowserWindow::show_form(QWidget *form) {
+	QWidget *current = mFormStack->currentWidget();
+	if (current == form) return;
+
+	//  Hidden forms must not contribute to the size of the stack
+	if (current) current->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+	form->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
+	mFormStack->setCurrentWidget(form);
+	mFormStack->adjustSize();
+}
+
+
+QWidget* BrowserWindow::find_form(const QString &key) {
+	QWidget *form = m_form_cache.value(key, nullptr);
+	if (form) {
+		m_form_lru.removeOne(key);
+		m_form_lru.append(key);
+	}
+	return form;
+}
+
+
+void BrowserWindow::cache_form(const QString &key, QWidget *form) {
+	form->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+	mFormStack->addWidget(form);
+	m_form_cache.insert(key, form);
+	m_form_lru.append(key);
+	while (m_form_lru.size() > FORM_CACHE_SIZE) {
+		remove_form(m_form_lru.first());
+	}
+}
+
+
+void BrowserWindow::remove_form(const QString &key) {
+	QWidget *form = m_form_cache.take(key);
+	m_form_lru.removeOne(key);
+	if (form == nullptr) return;
+
+	//  Nothing may be dispatched to the widgets until deleteLater() gets to them
+	QList<QIndigoProperty*> widgets = form->findChildren<QIndigoProperty*>();
+	for (auto i = widgets.constBegin(); i != widgets.constEnd(); ++i) mPropertyModel->detach_widget(*i);
+	if (mFormStack->currentWidget() == form) show_form(mEmptyForm);
+	mFormStack->removeWidget(form);
+	form->deleteLater();
+}
+
+
+void BrowserWindow::invalidate_forms(const char *device, const char *group) {
+	//  device == nullptr drops all forms, group == nullptr all forms of the device
+	QString prefix;
+	if (device) {
+		prefix.append(device);
+		prefix.append("\n");
+		if (group) {
+			prefix.append(group);
+			prefix.append("\n");
+		}
+	}
+	QList<QString> keys = m_form_cache.keys();
+	for (auto i = keys.constBegin(); i != keys.constEnd(); ++i) {
+		if ((*i).startsWith(prefix)) remove_form(*i);
+	}
+}
+
+
 void BrowserWindow::repaint_property_window(TreeNode* node) {
 	char selected_str[PATH_LEN] = "";
 
@@ -443,44 +772,51 @@ void BrowserWindow::repaint_property_window(TreeNode* node) {
 		mSelectionLine->setText(selected_str);
 
 		PropertyNode* p = reinterpret_cast<PropertyNode*>(node);
-		QIndigoProperty* ip = new QIndigoProperty(p->property);
-
-		QWidget* ppanel = new QWidget();
-		QVBoxLayout* playout = new QVBoxLayout;
-		playout->setSpacing(10);
-		playout->setContentsMargins(10, 10, 10, 10);
-		playout->setSizeConstraint(QLayout::SetMinimumSize);
-		ppanel->setLayout(playout);
-		playout->addWidget(ip);
-		mScrollArea->setWidget(ppanel);
-		ppanel->show();
-
-		//  Connect to update signals coming from indigo bus
-		connect(mPropertyModel, &PropertyModel::property_updated, ip, &QIndigoProperty::property_update);
+		QString key = form_key(p->property->device, p->property->group, p->property->name);
+		QWidget* ppanel = find_form(key);
+		if (ppanel == nullptr) {
+			QIndigoProperty* ip = new QIndigoProperty(p->property);
+
+			ppanel = new QWidget();
+			QVBoxLayout* playout = new QVBoxLayout;
+			playout->setSpacing(10);
+			playout->setContentsMargins(10, 10, 10, 10);
+			playout->setSizeConstraint(QLayout::SetMinimumSize);
+			ppanel->setLayout(playout);
+			playout->addWidget(ip);
+
+			//  Register for update signals coming from indigo bus
+			mPropertyModel->attach_widget(ip);
+			cache_form(key, ppanel);
+		}
+		show_form(ppanel);
 	} else if (node != nullptr && node->node_type == TREE_NODE_GROUP) {
 		indigo_debug("SELECTION CHANGED node->node_type == TREE_NODE_GROUP\n");
 		GroupNode* g = reinterpret_cast<GroupNode*>(node);
-		QWidget* ppanel = new QWidget();
-		QVBoxLayout* playout = new QVBoxLayout;
-		playout->setSpacing(10);
-		playout->setContentsMargins(10, 10, 10, 10);
-		playout->setSizeConstraint(QLayout::SetMinimumSize);
-		ppanel->setLayout(playout);
 		snprintf(selected_str, PATH_LEN, "%s . %s", current_path->device, current_path->group);
 		mSelectionLine->setText(selected_str);
 
-		//  Iterate properties
-		for (int i = 0; i < g->children.count; i++) {
-			PropertyNode* p = g->children.nodes[i];
-			QIndigoProperty* ip = new QIndigoProperty(p->property);
-			playout->addWidget(ip);
-			connect(mPropertyModel, &PropertyModel::property_updated, ip, &QIndigoProperty::property_update);
+		QString key = form_key(g->device(), g->name(), "");
+		QWidget* ppanel = find_form(key);
+		if (ppanel == nullptr) {
+			ppanel = new QWidget();
+			QVBoxLayout* playout = new QVBoxLayout;
+			playout->setSpacing(10);
+			playout->setContentsMargins(10, 10, 10, 10);
+			playout->setSizeConstraint(QLayout::SetMinimumSize);
+			ppanel->setLayout(playout);
+
+			//  Iterate properties
+			for (int i = 0; i < g->children.count; i++) {
+				PropertyNode* p = g->children.nodes[i];
+				QIndigoProperty* ip = new QIndigoProperty(p->property);
+				playout->addWidget(ip);
+				mPropertyModel->attach_widget(ip);
+			}
+			playout->addStretch(); // Fill the vertical space available
+			cache_form(key, ppanel);
 		}
-		playout->addStretch(); // Fill the vertical space available
-
-		mScrollArea->setWidget(ppanel);
-		mScrollArea->setWidgetResizable(true);
-		ppanel->show();
+		show_form(ppanel);
 	} else if (node != nullptr && node->node_type == TREE_NODE_DEVICE) {
 		indigo_debug("SELECTION CHANGED node->node_type == TREE_NODE_DEVICE\n");
 		DeviceNode* d = reinterpret_cast<DeviceNode*>(node);
@@ -534,6 +870,43 @@ void BrowserWindow::on_servers_act() {
 }
 
 
+void BrowserWindow::on_blob_trace_changed(bool status) {
+	BlobTrace::instance().set_enabled(status);
+	if(status) on_window_log(NULL, "BLOB latency tracing enabled");
+	else on_window_log(NULL, "BLOB latency tracing disabled");
+}
+
+
+void BrowserWindow::on_blob_trace_act() {
+	mBlobTrace->show();
+}
+
+
+void BrowserWindow::on_diagnostics_act() {
+	mDiagnostics->show();
+}
+
+
+void BrowserWindow::on_pin_act() {
+	if (current_path->type != TREE_NODE_PROPERTY || current_path->node == nullptr) {
+		on_window_log(NULL, "Select a property to pin it to the watch list");
+		return;
+	}
+	indigo_property *property = reinterpret_cast<PropertyNode*>(current_path->node)->property;
+	if (mWatchList->pinned(property)) {
+		mWatchList->unpin(QWatchList::key(property->device, property->name));
+	} else {
+		mWatchList->pin(property);
+		mWatchList->show();
+	}
+}
+
+
+void BrowserWindow::on_watch_list_act() {
+	mWatchList->show();
+}
+
+
 void BrowserWindow::on_exit_act() {
 	QApplication::quit();
 }
@@ -550,6 +923,30 @@ void BrowserWindow::on_blobs_changed(bool status) {
 }
 
 
+void BrowserWindow::on_archive_history_changed(bool status) {
+	conf.archive_history = status ? ARCHIVE_HISTORY_ON : ARCHIVE_HISTORY_OFF;
+	write_conf();
+	if (ReplayServer::instance().loaded()) return;
+	if (status) {
+		SessionArchive::instance().start(archive_directory().toUtf8().constData());
+		on_window_log(NULL, "Property history archive enabled");
+	} else {
+		SessionArchive::instance().stop();
+		on_window_log(NULL, "Property history archive disabled");
+	}
+}
+
+
+void BrowserWindow::on_live_preview_changed(bool status) {
+	conf.live_preview = status;
+	IndigoClient::instance().enable_live_preview(status);
+	write_conf();
+	if(status) on_window_log(NULL, "Live BLOB preview enabled");
+	else on_window_log(NULL, "Live BLOB preview disabled");
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
 void BrowserWindow::on_bonjour_changed(bool status) {
 	conf.auto_connect = status;
 	mServiceModel->enable_auto_connect(conf.auto_connect);
@@ -569,6 +966,9 @@ void BrowserWindow::on_use_state_icons_changed(bool status) {
 	conf.use_state_icons = status;
 	write_conf();
 	mProperties->repaint();
+	//  Widgets that are not rebuilt, like the watch list panels, keep their LED otherwise
+	mPropertyModel->restyle_widgets();
+	invalidate_forms(nullptr, nullptr);
 	repaint_property_window(current_path->node);
 	indigo_debug("%s\n", __FUNCTION__);
 }
@@ -590,6 +990,7 @@ void BrowserWindow::on_no_stretch() {
 	conf.preview_stretch_level = STRETCH_NONE;
 	preview_cache.set_stretch_level(conf.preview_stretch_level);
 	emit(rebuild_blob_previews());
+	invalidate_forms(nullptr, nullptr);
 	repaint_property_window(current_path->node);
 	write_conf();
 	indigo_error("%s\n", __FUNCTION__);
@@ -600,6 +1001,7 @@ void BrowserWindow::on_normal_stretch() {
 	conf.preview_stretch_level = STRETCH_NORMAL;
 	preview_cache.set_stretch_level(conf.preview_stretch_level);
 	emit(rebuild_blob_previews());
+	invalidate_forms(nullptr, nullptr);
 	repaint_property_window(current_path->node);
 	write_conf();
 	indigo_error("%s\n", __FUNCTION__);
@@ -610,12 +1012,37 @@ void BrowserWindow::on_hard_stretch() {
 	conf.preview_stretch_level = STRETCH_HARD;
 	preview_cache.set_stretch_level(conf.preview_stretch_level);
 	emit(rebuild_blob_previews());
+	invalidate_forms(nullptr, nullptr);
 	repaint_property_window(current_path->node);
 	write_conf();
 	indigo_error("%s\n", __FUNCTION__);
 }
 
 
+void BrowserWindow::on_fast_refresh() {
+	conf.tree_refresh_ms = TREE_REFRESH_FAST_MS;
+	mPropertyModel->set_refresh_interval(conf.tree_refresh_ms);
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
+void BrowserWindow::on_normal_refresh() {
+	conf.tree_refresh_ms = TREE_REFRESH_NORMAL_MS;
+	mPropertyModel->set_refresh_interval(conf.tree_refresh_ms);
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
+void BrowserWindow::on_low_power_refresh() {
+	conf.tree_refresh_ms = TREE_REFRESH_LOW_POWER_MS;
+	mPropertyModel->set_refresh_interval(conf.tree_refresh_ms);
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
 void BrowserWindow::on_log_error() {
 	conf.indigo_log_level = INDIGO_LOG_ERROR;
 	indigo_set_log_level(conf.indigo_log_level);
@@ -648,6 +1075,62 @@ void BrowserWindow::on_log_trace() {
 }
 
 
+void BrowserWindow::on_log_size_act() {
+	bool ok;
+	int lines = QInputDialog::getInt(this, tr("Message History"), tr("Number of messages to keep:"), conf.log_max_lines, 1000, 1000000, 1000, &ok);
+	if (!ok) return;
+	conf.log_max_lines = lines;
+	mLogModel->set_capacity(lines);
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
+void BrowserWindow::on_blob_name_template_act() {
+	bool ok;
+	QString name_template = QInputDialog::getText(
+		this,
+		tr("Saved BLOB File Names"),
+		tr("File name template:\n"
+		   "  %d device, %p property, %i item,\n"
+		   "  %t date and time, %n sequence number"),
+		QLineEdit::Normal,
+		conf.blob_name_template,
+		&ok
+	).trimmed();
+	if (!ok || name_template.isEmpty()) return;
+	if (!BlobFileNamer::valid_template(name_template.toUtf8().constData())) {
+		QMessageBox::warning(this, tr("Saved BLOB File Names"), tr("The template must contain %n, the sequence number."));
+		return;
+	}
+	strncpy(conf.blob_name_template, name_template.toUtf8().constData(), sizeof(conf.blob_name_template));
+	conf.blob_name_template[sizeof(conf.blob_name_template) - 1] = '\0';
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
+void BrowserWindow::on_blob_sync_none() {
+	conf.blob_sync = BLOB_SYNC_NONE;
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
+void BrowserWindow::on_blob_sync_file() {
+	conf.blob_sync = BLOB_SYNC_FILE;
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
+void BrowserWindow::on_blob_sync_batch() {
+	conf.blob_sync = BLOB_SYNC_BATCH;
+	write_conf();
+	indigo_debug("%s\n", __FUNCTION__);
+}
+
+
 void BrowserWindow::on_acl_load_act() {
 	QString filter = "INDIGO Device Access Control (*.idac);; All files (*)";
 	QString file_name = QFileDialog::getOpenFileName(this, "Load Device ACL...", QDir::currentPath(), filter);
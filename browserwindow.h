@@ -22,16 +22,26 @@
 
 #include <QApplication>
 #include <QMainWindow>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QPersistentModelIndex>
 #include <indigo/indigo_bus.h>
 #include <propertymodel.h>
 
-class QPlainTextEdit;
+class QListView;
+class QLineEdit;
+class LogModel;
 class QTreeView;
 class QServiceModel;
 class QItemSelection;
 class QVBoxLayout;
 class QScrollArea;
+class QStackedWidget;
 class QIndigoServers;
+class QBlobTrace;
+class QDiagnostics;
+class QWatchList;
 
 struct SelectionPath {
 
@@ -100,8 +110,11 @@ public slots:
 	void on_window_log(indigo_property* property, char *message);
 	void on_property_define(indigo_property* property, char *message);
 	void on_property_delete(indigo_property* property, char *message);
+	void on_node_removed(TreeNode* node);
 	void on_message_sent(indigo_property* property, char *message);
 	void on_blobs_changed(bool status);
+	void on_live_preview_changed(bool status);
+	void on_archive_history_changed(bool status);
 	void on_bonjour_changed(bool status);
 	void on_use_suffix_changed(bool status);
 	void on_use_state_icons_changed(bool status);
@@ -110,33 +123,82 @@ public slots:
 	void on_log_info();
 	void on_log_debug();
 	void on_log_trace();
+	void on_log_size_act();
+	void on_blob_name_template_act();
+	void on_blob_sync_none();
+	void on_blob_sync_file();
+	void on_blob_sync_batch();
+	void on_log_about_to_grow();
+	void on_log_grown();
 	void on_acl_load_act();
 	void on_acl_append_act();
 	void on_acl_save_act();
 	void on_acl_clear_act();
 	void on_servers_act();
+	void on_blob_trace_changed(bool status);
+	void on_blob_trace_act();
+	void on_diagnostics_act();
+	void on_pin_act();
+	void on_watch_list_act();
 	void on_exit_act();
 	void on_about_act();
 	void on_no_stretch();
 	void on_normal_stretch();
 	void on_hard_stretch();
+	void on_fast_refresh();
+	void on_normal_refresh();
+	void on_low_power_refresh();
+	void start_session();
 	void on_create_preview(indigo_property *property, indigo_item *item);
 	void on_obsolete_preview(indigo_property *property, indigo_item *item);
 	void on_remove_preview(indigo_property *property, indigo_item *item);
+	void apply_filter();
+	void refilter();
 
 private:
-	QPlainTextEdit* mLog;
+	QListView* mLog;
+	LogModel* mLogModel;
+	bool m_log_follow;
 	QTreeView* mProperties;
+	QLineEdit* mFilter;
+	/* PropertyIndex ids of the properties matching the filter and, for each
+	   group and device row, how many of them it has. Other rows are hidden.
+	*/
+	bool m_filter_active;
+	QSet<int> m_filter_matched;
+	QHash<QPersistentModelIndex, int> m_filter_parents;
 	QScrollArea* mScrollArea;
+	QStackedWidget* mFormStack;
+	QWidget* mEmptyForm;
 	QLabel* mSelectionLine;
 	QVBoxLayout* mFormLayout;
 
 	QIndigoServers *mIndigoServers;
+	QBlobTrace *mBlobTrace;
+	QDiagnostics *mDiagnostics;
+	QWatchList *mWatchList;
 	QServiceModel* mServiceModel;
 	PropertyModel* mPropertyModel;
 	SelectionPath* current_path;
+	bool m_first_property_seen;
+
+	/* Built property forms are kept in mFormStack and reused when the same
+	   group or property is selected again. The least recently used form
+	   is released when there are more than FORM_CACHE_SIZE of them.
+	*/
+	QHash<QString, QWidget*> m_form_cache;
+	QList<QString> m_form_lru;
 
 	void clear_window();
+	void show_form(QWidget *form);
+	QWidget* find_form(const QString &key);
+	void cache_form(const QString &key, QWidget *form);
+	void remove_form(const QString &key);
+	void invalidate_forms(const char *device, const char *group);
+
+	void set_filter_hidden(const QPersistentModelIndex &row, bool hide);
+	void set_filter_match(int id, bool matched);
+	void expand_filter_matches();
 };
 
 #endif // BROWSERWINDOW_H
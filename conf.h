@@ -31,9 +31,34 @@
 
 #define PROPERTY_AREA_MIN_WIDTH 620
 #define PREVIEW_WIDTH 550
+#define FORM_CACHE_SIZE 8
+
+/* Tree filter matches are expanded only when there are at most this many */
+#define FILTER_EXPAND_MAX 200
+
+#define TREE_REFRESH_FAST_MS 16
+#define TREE_REFRESH_NORMAL_MS 33
+#define TREE_REFRESH_LOW_POWER_MS 200
+
+/* Definitions arriving within this window are added to the tree together */
+#define TREE_DEFINE_BATCH_MS 50
+
+#define LOG_MAX_LINES 20000
+#define LOG_REFRESH_MS 33
 
 #define CONFIG_FILENAME "indigo_control_panel.conf"
 
+/* Starts at 1, zero in an older config means not set */
+typedef enum {
+	BLOB_SYNC_NONE = 1,
+	BLOB_SYNC_FILE = 2,
+	BLOB_SYNC_BATCH = 3
+} blob_sync_policy;
+
+/* Kept in one byte of conf_t, zero in an older config means not set */
+#define ARCHIVE_HISTORY_OFF 1
+#define ARCHIVE_HISTORY_ON 2
+
 typedef struct {
 	bool blobs_enabled;
 	bool auto_connect;
@@ -42,7 +67,13 @@ typedef struct {
 	bool use_state_icons;
 	bool use_system_locale;
 	preview_stretch preview_stretch_level;
-	char unused[1000];
+	int tree_refresh_ms;
+	int log_max_lines;
+	char blob_name_template[256];
+	blob_sync_policy blob_sync;
+	bool live_preview;
+	unsigned char archive_history;
+	char unused[730];
 } conf_t;
 
 extern conf_t conf;
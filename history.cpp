@@ -0,0 +1,120 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <math.h>
+#include <sys/time.h>
+#include "history.h"
+
+ItemHistory::ItemHistory() {
+	m_capacity = HISTORY_INITIAL_SIZE;
+	m_time = new double[m_capacity];
+	m_value = new double[m_capacity];
+	m_head = 0;
+	m_count = 0;
+}
+
+
+ItemHistory::~ItemHistory() {
+	delete[] m_time;
+	delete[] m_value;
+}
+
+
+/* Only called on a full ring, the samples are moved oldest first */
+void ItemHistory::grow() {
+	int capacity = m_capacity * 2;
+	double *times = new double[capacity];
+	double *values = new double[capacity];
+	for (int i = 0; i < m_count; i++) {
+		times[i] = time(i);
+		values[i] = value(i);
+	}
+	delete[] m_time;
+	delete[] m_value;
+	m_time = times;
+	m_value = values;
+	m_capacity = capacity;
+	m_head = m_count;
+}
+
+
+/* Index of the first sample not older than time, samples arrive in time order */
+int ItemHistory::lower_bound(double time) const {
+	int lo = 0, hi = m_count;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (this->time(mid) < time) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+
+/* Splits [from, to) into columns and gives the min and max of the samples
+   falling into each, NAN for a column without samples. Each sample is only
+   looked at once, however many there are per column.
+*/
+int ItemHistory::decimate(double from, double to, int columns, double *min, double *max) const {
+	for (int c = 0; c < columns; c++) min[c] = max[c] = NAN;
+	if (columns <= 0 || to <= from) return 0;
+
+	double scale = columns / (to - from);
+	int visited = 0;
+	for (int i = lower_bound(from); i < m_count; i++, visited++) {
+		double t = time(i);
+		if (t >= to) break;
+		double v = value(i);
+		int c = (int)((t - from) * scale);
+		if (c >= columns) c = columns - 1;
+		if (isnan(min[c]) || v < min[c]) min[c] = v;
+		if (isnan(max[c]) || v > max[c]) max[c] = v;
+	}
+	return visited;
+}
+
+
+void History::record(indigo_property *property) {
+	if (property->type != INDIGO_NUMBER_VECTOR) return;
+
+	QVector<ItemHistory*> &items = m_properties[property];
+	if (items.isEmpty()) {
+		for (int i = 0; i < property->count; i++) items.append(new ItemHistory());
+	}
+
+	struct timeval now;
+	gettimeofday(&now, nullptr);
+	double time = now.tv_sec + now.tv_usec / 1000000.0;
+	for (int i = 0; i < property->count && i < items.size(); i++) {
+		items[i]->append(time, property->items[i].number.value);
+	}
+}
+
+
+void History::remove(indigo_property *property) {
+	auto i = m_properties.find(property);
+	if (i == m_properties.end()) return;
+	qDeleteAll(i.value());
+	m_properties.erase(i);
+}
+
+
+const ItemHistory* History::find(indigo_property *property, int item) const {
+	auto i = m_properties.constFind(property);
+	if (i == m_properties.constEnd() || item < 0 || item >= i.value().size()) return nullptr;
+	return i.value()[item];
+}
@@ -0,0 +1,95 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <QHash>
+#include <QVector>
+#include <indigo/indigo_bus.h>
+
+/* Rings start at HISTORY_INITIAL_SIZE samples and double while they are full,
+   up to HISTORY_SIZE (~1.8 hours at 10 Hz). Both are powers of two.
+*/
+#define HISTORY_INITIAL_SIZE 256
+#define HISTORY_SIZE 65536
+
+/* Ring of samples of one item. Times and values are kept in separate arrays,
+   appending only allocates when the ring grows, at most 8 times per item.
+   Sample 0 is the oldest.
+*/
+class ItemHistory {
+public:
+	ItemHistory();
+	~ItemHistory();
+
+	void append(double time, double value) {
+		if (m_count == m_capacity && m_capacity < HISTORY_SIZE) grow();
+		m_time[m_head] = time;
+		m_value[m_head] = value;
+		m_head = (m_head + 1) & (m_capacity - 1);
+		if (m_count < m_capacity) m_count++;
+	}
+
+	int count() const { return m_count; }
+	double time(int i) const { return m_time[slot(i)]; }
+	double value(int i) const { return m_value[slot(i)]; }
+
+	int lower_bound(double time) const;
+	int decimate(double from, double to, int columns, double *min, double *max) const;
+
+private:
+	int slot(int i) const { return (m_head - m_count + i) & (m_capacity - 1); }
+	void grow();
+
+	double *m_time;
+	double *m_value;
+	int m_capacity;
+	int m_head;
+	int m_count;
+};
+
+
+/* History of the number properties in the tree, recorded on the GUI thread
+   as updates are applied. Properties are found by the pointer held by their
+   PropertyNode, the model drops the history when the property, its group
+   or its device is deleted. Items get their ring
+   on the first update, defined but never updated properties cost nothing.
+*/
+class History {
+public:
+	static History& instance();
+
+	void record(indigo_property *property);
+	void remove(indigo_property *property);
+	const ItemHistory* find(indigo_property *property, int item) const;
+
+private:
+	History() {}
+
+	QHash<indigo_property*, QVector<ItemHistory*>> m_properties;
+};
+
+
+inline History& History::instance() {
+	static History* me = nullptr;
+	if (!me) me = new History();
+	return *me;
+}
+
+#endif // HISTORY_H
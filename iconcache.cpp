@@ -0,0 +1,102 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski & David Hulse
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <stdio.h>
+#include <indigo/indigo_names.h>
+#include "iconcache.h"
+
+
+device_icon_type device_icon_for_interface(int interfaces) {
+	if (interfaces & INDIGO_INTERFACE_CCD) return DEVICE_ICON_CCD;
+	if (interfaces & INDIGO_INTERFACE_MOUNT) return DEVICE_ICON_MOUNT;
+	if (interfaces & INDIGO_INTERFACE_GUIDER) return DEVICE_ICON_GUIDER;
+	if (interfaces & INDIGO_INTERFACE_GPS) return DEVICE_ICON_GPS;
+	if (interfaces & INDIGO_INTERFACE_WHEEL) return DEVICE_ICON_WHEEL;
+	if (interfaces & INDIGO_INTERFACE_FOCUSER) return DEVICE_ICON_FOCUSER;
+	if (interfaces & INDIGO_INTERFACE_AO) return DEVICE_ICON_AO;
+	if (interfaces & INDIGO_INTERFACE_DOME) return DEVICE_ICON_DOME;
+	if (interfaces & INDIGO_INTERFACE_ROTATOR) return DEVICE_ICON_ROTATOR;
+	if (interfaces & INDIGO_INTERFACE_AUX) {
+		if (interfaces & INDIGO_INTERFACE_AUX_POWERBOX & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_POWERBOX;
+		if (interfaces & INDIGO_INTERFACE_AUX_WEATHER & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_WEATHER;
+		if (interfaces & INDIGO_INTERFACE_AUX_JOYSTICK & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_JOYSTICK;
+		if (interfaces & INDIGO_INTERFACE_AUX_SHUTTER & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_SHUTTER;
+		if (interfaces & INDIGO_INTERFACE_AUX_SQM & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_SQM;
+		if (interfaces & INDIGO_INTERFACE_AUX_LIGHTBOX & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_FLATBOX;
+		if (interfaces & INDIGO_INTERFACE_AUX_DUSTCAP & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_DUSTCAP;
+		if (interfaces & INDIGO_INTERFACE_AUX_GPIO & ~INDIGO_INTERFACE_AUX) return DEVICE_ICON_GPIO;
+	}
+	if (interfaces == 0) return DEVICE_ICON_SERVER;
+	return DEVICE_ICON_GENERIC;
+}
+
+
+IconCache::IconCache() {
+	m_state_leds[0][INDIGO_IDLE_STATE] = QPixmap(":resource/led-grey.png");
+	m_state_leds[0][INDIGO_BUSY_STATE] = QPixmap(":resource/led-orange.png");
+	m_state_leds[0][INDIGO_ALERT_STATE] = QPixmap(":resource/led-red.png");
+	m_state_leds[0][INDIGO_OK_STATE] = QPixmap(":resource/led-green.png");
+
+	m_state_leds[1][INDIGO_IDLE_STATE] = m_state_leds[0][INDIGO_IDLE_STATE];
+	m_state_leds[1][INDIGO_BUSY_STATE] = QPixmap(":resource/led-orange-cb.png");
+	m_state_leds[1][INDIGO_ALERT_STATE] = QPixmap(":resource/led-red-cb.png");
+	m_state_leds[1][INDIGO_OK_STATE] = QPixmap(":resource/led-green-cb.png");
+
+	load_device_icon(DEVICE_ICON_CCD, "ccd");
+	load_device_icon(DEVICE_ICON_MOUNT, "mount");
+	load_device_icon(DEVICE_ICON_GUIDER, "guider");
+	load_device_icon(DEVICE_ICON_GPS, "gps");
+	load_device_icon(DEVICE_ICON_WHEEL, "wheel");
+	load_device_icon(DEVICE_ICON_FOCUSER, "focuser");
+	load_device_icon(DEVICE_ICON_AO, "ao");
+	load_device_icon(DEVICE_ICON_DOME, "dome");
+	load_device_icon(DEVICE_ICON_ROTATOR, "rotator");
+	load_device_icon(DEVICE_ICON_POWERBOX, "powerbox");
+	load_device_icon(DEVICE_ICON_WEATHER, "weather");
+	load_device_icon(DEVICE_ICON_JOYSTICK, "joystick");
+	load_device_icon(DEVICE_ICON_SHUTTER, "shutter");
+	load_device_icon(DEVICE_ICON_SQM, "sqm");
+	load_device_icon(DEVICE_ICON_FLATBOX, "flatbox");
+	load_device_icon(DEVICE_ICON_DUSTCAP, "dustcap");
+	load_device_icon(DEVICE_ICON_GPIO, "gpio");
+
+	QPixmap server(":resource/server.png");
+	for (int state = 0; state < STATE_COUNT; state++)
+		m_device_icons[DEVICE_ICON_SERVER][state] = server;
+
+	m_device_icons[DEVICE_ICON_GENERIC][INDIGO_IDLE_STATE] = QPixmap(":resource/led-grey-dev.png");
+	m_device_icons[DEVICE_ICON_GENERIC][INDIGO_BUSY_STATE] = m_state_leds[0][INDIGO_BUSY_STATE];
+	m_device_icons[DEVICE_ICON_GENERIC][INDIGO_ALERT_STATE] = m_state_leds[0][INDIGO_ALERT_STATE];
+	m_device_icons[DEVICE_ICON_GENERIC][INDIGO_OK_STATE] = QPixmap(":resource/led-green-dev.png");
+}
+
+
+void IconCache::load_device_icon(device_icon_type icon, const char *name) {
+	char resource[256];
+
+	//  Only connected devices are green, all other states are grey
+	snprintf(resource, sizeof(resource), ":resource/%s-grey.png", name);
+	QPixmap grey(resource);
+	snprintf(resource, sizeof(resource), ":resource/%s-green.png", name);
+	QPixmap green(resource);
+
+	for (int state = 0; state < STATE_COUNT; state++)
+		m_device_icons[icon][state] = grey;
+	m_device_icons[icon][INDIGO_OK_STATE] = green;
+}
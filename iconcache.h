@@ -0,0 +1,89 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski & David Hulse
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef ICONCACHE_H
+#define ICONCACHE_H
+
+#include <QPixmap>
+#include <indigo/indigo_bus.h>
+
+#define STATE_COUNT 4
+
+typedef enum {
+	DEVICE_ICON_CCD = 0,
+	DEVICE_ICON_MOUNT,
+	DEVICE_ICON_GUIDER,
+	DEVICE_ICON_GPS,
+	DEVICE_ICON_WHEEL,
+	DEVICE_ICON_FOCUSER,
+	DEVICE_ICON_AO,
+	DEVICE_ICON_DOME,
+	DEVICE_ICON_ROTATOR,
+	DEVICE_ICON_POWERBOX,
+	DEVICE_ICON_WEATHER,
+	DEVICE_ICON_JOYSTICK,
+	DEVICE_ICON_SHUTTER,
+	DEVICE_ICON_SQM,
+	DEVICE_ICON_FLATBOX,
+	DEVICE_ICON_DUSTCAP,
+	DEVICE_ICON_GPIO,
+	DEVICE_ICON_SERVER,
+	DEVICE_ICON_GENERIC,
+	DEVICE_ICON_COUNT
+} device_icon_type;
+
+/* Maps the INFO.DEVICE_INTERFACE bits to the icon shown in the tree */
+device_icon_type device_icon_for_interface(int interfaces);
+
+
+/* All state LEDs and device icons are decoded once, on first use, and
+   then handed out as shared pixmaps indexed by icon and state.
+*/
+class IconCache {
+public:
+	static IconCache& instance();
+
+	const QPixmap& state_led(indigo_property_state state, bool state_icons) const {
+		return m_state_leds[state_icons ? 1 : 0][state_index(state)];
+	}
+
+	const QPixmap& device_icon(device_icon_type icon, indigo_property_state state) const {
+		return m_device_icons[icon][state_index(state)];
+	}
+
+private:
+	IconCache();
+
+	static int state_index(indigo_property_state state) {
+		return ((unsigned)state < STATE_COUNT) ? state : INDIGO_IDLE_STATE;
+	}
+
+	void load_device_icon(device_icon_type icon, const char *name);
+
+	QPixmap m_state_leds[2][STATE_COUNT];
+	QPixmap m_device_icons[DEVICE_ICON_COUNT][STATE_COUNT];
+};
+
+inline IconCache& IconCache::instance() {
+	static IconCache* me = nullptr;
+	if (!me) me = new IconCache();
+	return *me;
+}
+
+#endif // ICONCACHE_H
@@ -21,6 +21,7 @@ SOURCES += \
 	browserwindow.cpp \
 	qindigoservice.cpp \
 	propertymodel.cpp \
+	propertyindex.cpp \
 	indigoclient.cpp \
 	qindigoproperty.cpp \
 	qindigoswitch.cpp \
@@ -28,7 +29,24 @@ SOURCES += \
 	qindigonumber.cpp \
 	qindigolight.cpp \
 	qindigoblob.cpp \
+	qimageview.cpp \
 	qindigoservers.cpp \
+	qblobtrace.cpp \
+	qdiagnostics.cpp \
+	qwatchlist.cpp \
+	qindigosparkline.cpp \
+	history.cpp \
+	sessionarchive.cpp \
+	archivereader.cpp \
+	iconcache.cpp \
+	logmodel.cpp \
+	blobrecorder.cpp \
+	blobnaming.cpp \
+	livepreview.cpp \
+	trafficlog.cpp \
+	replayserver.cpp \
+	blobtrace.cpp \
+	stats.cpp \
 	blobpreview.cpp \
 	fits/fits.c \
 	debayer/debayer.c \
@@ -105,6 +123,8 @@ HEADERS += \
 	browserwindow.h \
 	qindigoservice.h \
 	propertymodel.h \
+	nodepool.h \
+	propertyindex.h \
 	indigoclient.h \
 	qindigoproperty.h \
 	qindigoswitch.h \
@@ -112,8 +132,25 @@ HEADERS += \
 	qindigonumber.h \
 	qindigolight.h \
 	qindigoblob.h \
+	qimageview.h \
 	blobpreview.h \
 	qindigoservers.h \
+	qblobtrace.h \
+	qdiagnostics.h \
+	qwatchlist.h \
+	qindigosparkline.h \
+	history.h \
+	sessionarchive.h \
+	archivereader.h \
+	iconcache.h \
+	logmodel.h \
+	blobrecorder.h \
+	blobnaming.h \
+	livepreview.h \
+	trafficlog.h \
+	replayserver.h \
+	blobtrace.h \
+	stats.h \
 	logger.h \
 	fits/fits.h \
 	debayer/debayer.h \
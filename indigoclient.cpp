@@ -19,6 +19,12 @@
 
 #include <indigo/indigo_client.h>
 #include "indigoclient.h"
+#include "blobrecorder.h"
+#include "livepreview.h"
+#include "trafficlog.h"
+#include "sessionarchive.h"
+#include "blobtrace.h"
+#include "stats.h"
 
 
 static indigo_result client_attach(indigo_client *client) {
@@ -29,6 +35,10 @@ static indigo_result client_attach(indigo_client *client) {
 
 static indigo_result client_define_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
 	Q_UNUSED(device);
+	TrafficLog::instance().record(TRAFFIC_DEFINE, property, message);
+	SessionArchive::instance().record(property);
+	Stats::instance().add(STAT_BUS_DEFINES);
+	Stats::instance().device_event(property->device);
 	//  Deep copy the property so it won't disappear on us later
 	static indigo_property* p = nullptr;
 	switch (property->type) {
@@ -70,6 +80,7 @@ static indigo_result client_define_property(indigo_client *client, indigo_device
 	}
 	memcpy(p, property, sizeof(indigo_property) + property->count * sizeof(indigo_item));
 
+	Stats::instance().add(STAT_QUEUED_SIGNALS);
 	if (message) {
 		static char *msg;
 		msg = (char*)malloc(INDIGO_VALUE_SIZE);
@@ -78,6 +89,7 @@ static indigo_result client_define_property(indigo_client *client, indigo_device
 	} else {
 		emit(IndigoClient::instance().property_defined(p, NULL));
 	}
+	IndigoClient::instance().notify_activity();
 	return INDIGO_OK;
 }
 
@@ -85,6 +97,10 @@ static indigo_result client_define_property(indigo_client *client, indigo_device
 static indigo_result client_update_property(indigo_client *client, indigo_device *device, indigo_property *property, const char *message) {
 	Q_UNUSED(client);
 	Q_UNUSED(device);
+	TrafficLog::instance().record(TRAFFIC_UPDATE, property, message);
+	SessionArchive::instance().record(property);
+	Stats::instance().add(STAT_BUS_UPDATES);
+	Stats::instance().device_event(property->device);
 	static indigo_property* p = nullptr;
 	switch (property->type) {
 	case INDIGO_TEXT_VECTOR:
@@ -101,12 +117,26 @@ static indigo_result client_update_property(indigo_client *client, indigo_device
 		break;
 	case INDIGO_BLOB_VECTOR:
 		if (property->state == INDIGO_OK_STATE) {
+			BlobTrace &trace = BlobTrace::instance();
+			qint64 received_us = trace.enabled() ? trace.now_us() : 0;
 			for (int row = 0; row < property->count; row++) {
-				if (*property->items[row].blob.url && indigo_populate_http_blob_item(&property->items[row])) {
-					indigo_log("Image URL received (%s, %ld bytes)...\n", property->items[0].blob.url, property->items[0].blob.size);
+				qint64 download_us = 0;
+				if (*property->items[row].blob.url) {
+					if (trace.enabled()) download_us = trace.now_us();
+					if (indigo_populate_http_blob_item(&property->items[row]))
+						indigo_log("Image URL received (%s, %ld bytes)...\n", property->items[0].blob.url, property->items[0].blob.size);
 				}
-				emit(IndigoClient::instance().create_preview(property, &property->items[row]));
+				if (trace.enabled())
+					trace.begin_frame(preview_key(property->device, property->name, property->items[row].name), received_us, download_us);
+				if (IndigoClient::instance().m_recorder)
+					IndigoClient::instance().m_recorder->enqueue(property, &property->items[row]);
+				if (IndigoClient::instance().live_preview())
+					LivePreview::instance().submit(property, &property->items[row]);
+				else
+					emit(IndigoClient::instance().create_preview(property, &property->items[row]));
 			}
+		} else if (property->state == INDIGO_BUSY_STATE && IndigoClient::instance().live_preview()) {
+			/* streaming cameras stay busy, keep showing the last frame */
 		} else if(property->state == INDIGO_BUSY_STATE) {
 			for (int row = 0; row < property->count; row++) {
 				emit(IndigoClient::instance().obsolete_preview(property, &property->items[row]));
@@ -121,6 +151,7 @@ static indigo_result client_update_property(indigo_client *client, indigo_device
 	}
 
 	memcpy(p, property, sizeof(indigo_property) + property->count * sizeof(indigo_item));
+	Stats::instance().add(STAT_QUEUED_SIGNALS);
 	if (message) {
 		static char *msg;
 		msg = (char*)malloc(INDIGO_VALUE_SIZE);
@@ -137,6 +168,9 @@ static indigo_result client_delete_property(indigo_client *client, indigo_device
 	Q_UNUSED(client);
 	Q_UNUSED(device);
 	indigo_debug("Deleting property [%s] on device [%s]\n", property->name, property->device);
+	TrafficLog::instance().record(TRAFFIC_DELETE, property, message);
+	Stats::instance().add(STAT_BUS_DELETES);
+	Stats::instance().device_event(property->device);
 
 	if (property->type == INDIGO_BLOB_VECTOR) {
 		for (int row = 0; row < property->count; row++) {
@@ -149,6 +183,7 @@ static indigo_result client_delete_property(indigo_client *client, indigo_device
 	strcpy(p->group, property->group);
 	strcpy(p->name, property->name);
 
+	Stats::instance().add(STAT_QUEUED_SIGNALS);
 	if (message) {
 		static char *msg;
 		msg = (char*)malloc(INDIGO_VALUE_SIZE);
@@ -157,6 +192,7 @@ static indigo_result client_delete_property(indigo_client *client, indigo_device
 	} else {
 		emit(IndigoClient::instance().property_deleted(p, NULL));
 	}
+	IndigoClient::instance().notify_activity();
 	return INDIGO_OK;
 }
 
@@ -165,6 +201,8 @@ static indigo_result client_send_message(indigo_client *client, indigo_device *d
 	Q_UNUSED(client);
 
 	if (!message) return INDIGO_OK;
+	TrafficLog::instance().record_message(device ? device->name : nullptr, message);
+	Stats::instance().add(STAT_BUS_MESSAGES);
 
 	static char *msg;
 	msg = (char*)malloc(INDIGO_VALUE_SIZE);
@@ -201,3 +239,39 @@ void IndigoClient::start(char *name) {
 	strncpy(client.name, name, INDIGO_NAME_SIZE);
 	indigo_attach_client(&client);
 }
+
+void IndigoClient::stop() {
+	indigo_detach_client(&client);
+	indigo_stop();
+}
+
+
+static void replay_device(indigo_device *device, const char *name) {
+	memset(device, 0, sizeof(indigo_device));
+	strncpy(device->name, name, INDIGO_NAME_SIZE);
+	device->version = INDIGO_VERSION_CURRENT;
+}
+
+void IndigoClient::inject_define(indigo_property *property, const char *message) {
+	indigo_device device;
+	replay_device(&device, property->device);
+	client_define_property(&client, &device, property, message);
+}
+
+void IndigoClient::inject_update(indigo_property *property, const char *message) {
+	indigo_device device;
+	replay_device(&device, property->device);
+	client_update_property(&client, &device, property, message);
+}
+
+void IndigoClient::inject_delete(indigo_property *property, const char *message) {
+	indigo_device device;
+	replay_device(&device, property->device);
+	client_delete_property(&client, &device, property, message);
+}
+
+void IndigoClient::inject_message(const char *device_name, const char *message) {
+	indigo_device device;
+	replay_device(&device, device_name);
+	client_send_message(&client, &device, message);
+}
@@ -21,9 +21,11 @@
 #define INDIGOCLIENT_H
 
 #include <QObject>
+#include <QAtomicInt>
 #include <indigo/indigo_bus.h>
 #include "logger.h"
 
+class BlobRecorder;
 
 class IndigoClient : public QObject
 {
@@ -36,6 +38,8 @@ public:
 	IndigoClient() {
 		m_logger = &Logger::instance();
 		m_blobs_enabled = false;
+		m_recorder = nullptr;
+		m_live_preview = false;
 	}
 
 	void enable_blobs(bool enable) {
@@ -46,9 +50,48 @@ public:
 		return m_blobs_enabled;
 	};
 
+	/* In live mode BLOB updates go to LivePreview instead of create_preview() */
+	void enable_live_preview(bool enable) {
+		m_live_preview = enable;
+	}
+
+	bool live_preview() {
+		return m_live_preview;
+	}
+
+	/* Incoming BLOBs are also handed to the recorder, if one is set */
+	void set_recorder(BlobRecorder *recorder) {
+		m_recorder = recorder;
+	}
+
 	void start(char *name);
+	void stop();
+
+	/* Feed events into the client callbacks as if the bus delivered them,
+	   ReplayServer uses these to stand in for a server
+	*/
+	void inject_define(indigo_property *property, const char *message);
+	void inject_update(indigo_property *property, const char *message);
+	void inject_delete(indigo_property *property, const char *message);
+	void inject_message(const char *device, const char *message);
+
+	/* Called from the indigo threads whenever devices come or go. Bursts
+	   are folded into one queued server_activity() until the receiver
+	   calls activity_handled().
+	*/
+	void notify_activity() {
+		if (m_activity_pending.testAndSetOrdered(0, 1)) emit(server_activity());
+	}
+
+	void activity_handled() {
+		m_activity_pending.storeRelease(0);
+	}
 
 	Logger* m_logger;
+	BlobRecorder* m_recorder;
+	bool m_live_preview;
+	QAtomicInt m_activity_pending;
+
 signals:
 	/* When this signals are issued new copies of the prorpety and message will be passed.
 	   They need to be freed with free() when not needed.
@@ -64,6 +107,9 @@ signals:
 	void create_preview(indigo_property* property, indigo_item *item);
 	void obsolete_preview(indigo_property* property, indigo_item *item);
 	void remove_preview(indigo_property* property, indigo_item *item);
+
+	/* Properties were defined or deleted, a server may have connected or dropped */
+	void server_activity();
 };
 
 inline IndigoClient& IndigoClient::instance() {
@@ -0,0 +1,216 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <stdlib.h>
+#include <string.h>
+#include "livepreview.h"
+#include "blobpreview.h"
+#include "blobtrace.h"
+
+
+static double elapsed_ms(const struct timeval &from, const struct timeval &to) {
+	return (to.tv_sec - from.tv_sec) * 1000.0 + (to.tv_usec - from.tv_usec) / 1000.0;
+}
+
+
+LivePreview::LivePreview() : m_running(false) {
+	pthread_mutex_init(&m_mutex, nullptr);
+	pthread_cond_init(&m_cond, nullptr);
+}
+
+
+bool LivePreview::start() {
+	if (m_running) return true;
+	m_running = true;
+	if (pthread_create(&m_thread, nullptr, worker_thread, this) != 0) {
+		indigo_error("Can not start live preview thread\n");
+		m_running = false;
+		return false;
+	}
+	return true;
+}
+
+
+void LivePreview::stop() {
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_running = false;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+	pthread_join(m_thread, nullptr);
+}
+
+
+/* Called on the indigo thread, only copies the frame */
+void LivePreview::submit(indigo_property *property, indigo_item *item) {
+	if (item->blob.value == nullptr || item->blob.size <= 0) return;
+
+	QString key = preview_key(property->device, property->name, item->name);
+
+	pthread_mutex_lock(&m_mutex);
+	live_stream *stream = m_streams.value(key, nullptr);
+	if (stream == nullptr) {
+		stream = new live_stream();
+		stream->key = key;
+		m_streams.insert(key, stream);
+	}
+	if (stream->pending_capacity < item->blob.size) {
+		void *buffer = realloc(stream->pending, item->blob.size);
+		if (buffer == nullptr) {
+			pthread_mutex_unlock(&m_mutex);
+			return;
+		}
+		stream->pending = buffer;
+		stream->pending_capacity = item->blob.size;
+	}
+	if (stream->has_pending) stream->dropped++;
+	memcpy(stream->pending, item->blob.value, item->blob.size);
+	stream->pending_size = item->blob.size;
+	strncpy(stream->format, item->blob.format, INDIGO_NAME_SIZE);
+	gettimeofday(&stream->pending_time, nullptr);
+	stream->has_pending = true;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+QString LivePreview::overlay(const QString &key) {
+	QString text;
+	pthread_mutex_lock(&m_mutex);
+	live_stream *stream = m_streams.value(key, nullptr);
+	if (stream != nullptr && stream->fps > 0) {
+		text = QString("%1 fps  %2 ms  %3 dropped").arg(stream->fps, 0, 'f', 1).arg(stream->latency_ms, 0, 'f', 0).arg(stream->dropped);
+	}
+	pthread_mutex_unlock(&m_mutex);
+	return text;
+}
+
+
+/* Called with m_mutex held, a stream being decoded is freed by the worker */
+void LivePreview::release(live_stream *stream) {
+	if (stream->decoding) {
+		stream->removed = true;
+		return;
+	}
+	free(stream->pending);
+	free(stream->work);
+	delete stream;
+}
+
+
+void LivePreview::remove(const QString &key) {
+	pthread_mutex_lock(&m_mutex);
+	live_stream *stream = m_streams.take(key);
+	if (stream != nullptr) release(stream);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void LivePreview::remove_device(const char *device) {
+	QString prefix(device);
+	prefix.append(".");
+	pthread_mutex_lock(&m_mutex);
+	for (auto i = m_streams.begin(); i != m_streams.end();) {
+		if (i.key().startsWith(prefix)) {
+			release(i.value());
+			i = m_streams.erase(i);
+		} else {
+			++i;
+		}
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+/* Called with m_mutex held */
+live_stream* LivePreview::next_pending() {
+	for (auto i = m_streams.constBegin(); i != m_streams.constEnd(); ++i) {
+		if (i.value()->has_pending) return i.value();
+	}
+	return nullptr;
+}
+
+
+void* LivePreview::worker_thread(void *arg) {
+	LivePreview *live = (LivePreview *)arg;
+
+	pthread_mutex_lock(&live->m_mutex);
+	while (true) {
+		live_stream *stream;
+		while ((stream = live->next_pending()) == nullptr && live->m_running)
+			pthread_cond_wait(&live->m_cond, &live->m_mutex);
+		if (!live->m_running) break;
+
+		/* swap the buffers, the indigo thread can fill the next frame meanwhile */
+		void *buffer = stream->work;
+		long capacity = stream->work_capacity;
+		stream->work = stream->pending;
+		stream->work_capacity = stream->pending_capacity;
+		stream->pending = buffer;
+		stream->pending_capacity = capacity;
+		stream->has_pending = false;
+		long size = stream->pending_size;
+		struct timeval received = stream->pending_time;
+		char format[INDIGO_NAME_SIZE];
+		strncpy(format, stream->format, INDIGO_NAME_SIZE);
+		stream->decoding = true;
+		pthread_mutex_unlock(&live->m_mutex);
+
+		live->decode(stream, format, size, received);
+
+		pthread_mutex_lock(&live->m_mutex);
+		stream->decoding = false;
+		if (stream->removed) live->release(stream);
+	}
+	pthread_mutex_unlock(&live->m_mutex);
+	return nullptr;
+}
+
+
+/* A stream removed meanwhile is only freed after this returns, so it stays
+   valid without the lock
+*/
+void LivePreview::decode(live_stream *stream, const char *format, long size, const struct timeval &received) {
+	if (BlobTrace::instance().enabled()) BlobTrace::instance().dequeue(stream->key);
+	QImage *image = create_preview(format, (unsigned char *)stream->work, size);
+	if (image == nullptr) return;
+	preview_cache.insert_preview(stream->key, new preview_image(*image));
+	delete image;
+
+	struct timeval now;
+	gettimeofday(&now, nullptr);
+
+	pthread_mutex_lock(&m_mutex);
+	double latency = elapsed_ms(received, now);
+	stream->latency_ms = stream->latency_ms > 0 ? stream->latency_ms + LIVE_PREVIEW_SMOOTHING * (latency - stream->latency_ms) : latency;
+	if (stream->last_shown.tv_sec) {
+		double interval = elapsed_ms(stream->last_shown, now);
+		if (interval > 0) {
+			double fps = 1000.0 / interval;
+			stream->fps = stream->fps > 0 ? stream->fps + LIVE_PREVIEW_SMOOTHING * (fps - stream->fps) : fps;
+		}
+	}
+	stream->last_shown = now;
+	pthread_mutex_unlock(&m_mutex);
+
+	emit(frame_ready(stream->key));
+}
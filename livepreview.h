@@ -0,0 +1,101 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LIVEPREVIEW_H
+#define LIVEPREVIEW_H
+
+#include <pthread.h>
+#include <sys/time.h>
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <indigo/indigo_bus.h>
+
+/* Weight of the newest sample in the fps and latency averages */
+#define LIVE_PREVIEW_SMOOTHING 0.1
+
+struct live_stream {
+	QString key;
+	char format[INDIGO_NAME_SIZE];
+
+	/* written by the indigo thread, the newest frame replaces an unread one */
+	void *pending;
+	long pending_size;
+	long pending_capacity;
+	struct timeval pending_time;
+	bool has_pending;
+
+	/* owned by the worker while it decodes */
+	void *work;
+	long work_capacity;
+	bool decoding;
+	/* removed while decoding, the worker frees it when done */
+	bool removed;
+
+	double fps;
+	double latency_ms;
+	unsigned long dropped;
+	struct timeval last_shown;
+};
+
+
+/* Live preview of BLOB streams. Frames are double buffered per stream: the
+   indigo thread copies each new frame into the pending buffer, replacing
+   one that has not been picked up yet, and the worker thread swaps it with
+   its own buffer, decodes it and puts the preview into preview_cache. The
+   display never has more than one frame queued, so it can not fall behind.
+*/
+class LivePreview : public QObject {
+	Q_OBJECT
+public:
+	static LivePreview& instance();
+
+	bool start();
+	void stop();
+	void submit(indigo_property *property, indigo_item *item);
+	QString overlay(const QString &key);
+	/* Frees the stream of one item or all streams of a device */
+	void remove(const QString &key);
+	void remove_device(const char *device);
+
+signals:
+	void frame_ready(const QString &key);
+
+private:
+	LivePreview();
+
+	static void* worker_thread(void *arg);
+	live_stream* next_pending();
+	void decode(live_stream *stream, const char *format, long size, const struct timeval &received);
+	void release(live_stream *stream);
+
+	QHash<QString, live_stream*> m_streams;
+	pthread_t m_thread;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	bool m_running;
+};
+
+inline LivePreview& LivePreview::instance() {
+	static LivePreview* me = nullptr;
+	if (!me) me = new LivePreview();
+	return *me;
+}
+
+#endif // LIVEPREVIEW_H
@@ -0,0 +1,148 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <QColor>
+#include <time.h>
+#include "logmodel.h"
+#include "conf.h"
+
+
+LogModel::LogModel(int capacity, QObject *parent) : QAbstractListModel(parent), m_capacity(capacity > 0 ? capacity : LOG_MAX_LINES), m_first(0), m_count(0) {
+	m_flush_timer.setSingleShot(true);
+	m_flush_timer.setInterval(LOG_REFRESH_MS);
+	connect(&m_flush_timer, &QTimer::timeout, this, &LogModel::flush_pending);
+}
+
+
+int LogModel::rowCount(const QModelIndex &parent) const {
+	if (parent.isValid()) return 0;
+	return m_count;
+}
+
+
+QVariant LogModel::data(const QModelIndex &index, int role) const {
+	if (!index.isValid() || index.row() >= m_count) return QVariant();
+
+	const LogEntry &e = entry(index.row());
+
+	if (role == Qt::DisplayRole) {
+		char timestamp[16];
+		time_t secs = e.timestamp.tv_sec;
+		struct tm *lt = localtime(&secs);
+		if (lt == nullptr) {
+			secs = time(nullptr);
+			lt = localtime(&secs);
+		}
+		strftime(timestamp, sizeof(timestamp), "%H:%M:%S", lt);
+		snprintf(timestamp + 8, sizeof(timestamp) - 8, ".%03ld", (long)e.timestamp.tv_usec/1000);
+
+		if (e.device[0] != '\0')
+			return QString("%1 %2.%3: %4").arg(timestamp, e.device, e.property, e.message);
+		return QString("%1 %2").arg(timestamp, e.message);
+	} else if (role == Qt::ForegroundRole) {
+		if (e.device[0] == '\0') return QVariant();
+		switch (e.state) {
+		case INDIGO_ALERT_STATE:
+			return QColor(0xE0, 0x00, 0x00);
+		case INDIGO_BUSY_STATE:
+			return QColor("orange");
+		default:
+			return QVariant();
+		}
+	}
+	return QVariant();
+}
+
+
+void LogModel::append(indigo_property *property, const char *message) {
+	LogEntry e;
+	gettimeofday(&e.timestamp, nullptr);
+	if (property) {
+		strncpy(e.device, property->device, INDIGO_NAME_SIZE);
+		strncpy(e.property, property->name, INDIGO_NAME_SIZE);
+		e.state = property->state;
+	} else {
+		e.device[0] = '\0';
+		e.property[0] = '\0';
+		e.state = INDIGO_OK_STATE;
+	}
+	e.message = QString::fromUtf8(message);
+
+	/* no point in keeping more than a full ring waiting */
+	if (m_pending.size() >= m_capacity) m_pending.removeFirst();
+	m_pending.append(e);
+
+	if (!m_flush_timer.isActive()) m_flush_timer.start();
+}
+
+
+void LogModel::flush_pending() {
+	int incoming = m_pending.size();
+	if (incoming == 0) return;
+
+	int overflow = m_count + incoming - m_capacity;
+	if (overflow > 0) {
+		beginRemoveRows(QModelIndex(), 0, overflow - 1);
+		m_first = (m_first + overflow) % m_capacity;
+		m_count -= overflow;
+		endRemoveRows();
+	}
+
+	beginInsertRows(QModelIndex(), m_count, m_count + incoming - 1);
+	for (int i = 0; i < incoming; i++) {
+		int slot = (m_first + m_count) % m_capacity;
+		/* the ring grows up to capacity and is reused after that */
+		if (slot == m_entries.size())
+			m_entries.append(m_pending[i]);
+		else
+			m_entries[slot] = m_pending[i];
+		m_count++;
+	}
+	m_pending.clear();
+	endInsertRows();
+}
+
+
+void LogModel::set_capacity(int capacity) {
+	if (capacity <= 0 || capacity == m_capacity) return;
+
+	flush_pending();
+	beginResetModel();
+	int keep = qMin(m_count, capacity);
+	QVector<LogEntry> entries;
+	entries.reserve(keep);
+	for (int row = m_count - keep; row < m_count; row++)
+		entries.append(entry(row));
+	m_entries.swap(entries);
+	m_capacity = capacity;
+	m_first = 0;
+	m_count = keep;
+	endResetModel();
+}
+
+
+void LogModel::clear() {
+	m_flush_timer.stop();
+	beginResetModel();
+	m_pending.clear();
+	m_entries.clear();
+	m_first = 0;
+	m_count = 0;
+	endResetModel();
+}
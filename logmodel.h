@@ -0,0 +1,75 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef LOGMODEL_H
+#define LOGMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include <QString>
+#include <QTimer>
+#include <sys/time.h>
+#include <indigo/indigo_bus.h>
+
+struct LogEntry {
+	struct timeval timestamp;
+	char device[INDIGO_NAME_SIZE];
+	char property[INDIGO_NAME_SIZE];
+	indigo_property_state state;
+	QString message;
+};
+
+
+/* Message log kept as a bounded ring of structured entries. Lines are
+   formatted only when the view asks for them, and appends are collected
+   and handed to the view in one batch per refresh interval. When the ring
+   is full the oldest lines are dropped.
+*/
+class LogModel : public QAbstractListModel {
+	Q_OBJECT
+public:
+	explicit LogModel(int capacity, QObject *parent = nullptr);
+
+	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+	void append(indigo_property *property, const char *message);
+	void set_capacity(int capacity);
+	int capacity() const { return m_capacity; }
+
+public slots:
+	void clear();
+
+private slots:
+	void flush_pending();
+
+private:
+	const LogEntry& entry(int row) const {
+		return m_entries[(m_first + row) % m_capacity];
+	}
+
+	QVector<LogEntry> m_entries;
+	QVector<LogEntry> m_pending;
+	QTimer m_flush_timer;
+	int m_capacity;
+	int m_first;
+	int m_count;
+};
+
+#endif // LOGMODEL_H
@@ -21,12 +21,36 @@
 #include <QDir>
 #include <QStandardPaths>
 #include <QTextStream>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <signal.h>
+#include <limits.h>
 #include "browserwindow.h"
+#include "qservicemodel.h"
+#include "indigoclient.h"
+#include "blobrecorder.h"
+#include "blobnaming.h"
+#include "livepreview.h"
+#include "trafficlog.h"
+#include "replayserver.h"
+#include "sessionarchive.h"
+#include "archivereader.h"
 #include <conf.h>
 
 conf_t conf;
 char config_path[PATH_LEN];
 
+static bool startup_trace_enabled = false;
+static QElapsedTimer startup_timer;
+
+void startup_trace(const char *phase) {
+	static qint64 last_ms = 0;
+	if (!startup_trace_enabled) return;
+	qint64 now_ms = startup_timer.elapsed();
+	fprintf(stderr, "startup: %-24s %6lld ms (+%lld ms)\n", phase, (long long)now_ms, (long long)(now_ms - last_ms));
+	last_ms = now_ms;
+}
+
 void write_conf() {
 	char filename[PATH_LEN];
 	snprintf(filename, PATH_LEN, "%s/%s", config_path, CONFIG_FILENAME);
@@ -48,7 +72,107 @@ void read_conf() {
 }
 
 
+QString archive_directory() {
+	return QString("%1/%2").arg(config_path, ARCHIVE_DIRECTORY);
+}
+
+
+/* Prints the samples of all series in [from, to) seconds since the session start as CSV */
+static int dump_archive(const char *path, double from, double to) {
+	ArchiveReader reader;
+	if (!reader.open(path)) return 1;
+
+	unsigned long long start = reader.session_start();
+	unsigned long long from_usec = start + (unsigned long long)(from * 1000000);
+	unsigned long long to_usec = (to > 0) ? start + (unsigned long long)(to * 1000000) : ULLONG_MAX;
+	QVector<archive_sample> samples;
+	printf("time,device,property,item,value\n");
+	for (int i = 0; i < reader.series().size(); i++) {
+		const archive_series &series = reader.series()[i];
+		samples.resize(0);
+		reader.query(i, from_usec, to_usec, samples);
+		for (auto s = samples.constBegin(); s != samples.constEnd(); ++s) {
+			printf("%.6f,\"%s\",%s,%s,%.15g\n", s->usec / 1000000.0, series.device, series.property, series.item, s->value);
+		}
+	}
+	return 0;
+}
+
+
+/* Only the flag is set in the handler, the event loop quits from a timer */
+#define HEADLESS_QUIT_POLL_MS 200
+
+static volatile sig_atomic_t headless_quit_requested = 0;
+
+static void headless_quit(int) {
+	headless_quit_requested = 1;
+}
+
+
+/* No windows, only discovery, the client and the BLOB recorder */
+static int run_headless(int argc, char *argv[], const char *record_dir) {
+	QCoreApplication app(argc, argv);
+
+	QDir dir("");
+	dir.mkpath(record_dir);
+	BlobRecorder &recorder = BlobRecorder::instance();
+	recorder.set_directory(record_dir);
+	if (!recorder.start()) return 1;
+
+	// Nobody keeps the property copies in this mode, release them right away
+	IndigoClient &client = IndigoClient::instance();
+	QObject::connect(&client, &IndigoClient::property_defined, [](indigo_property *property, char *message) {
+		indigo_release_property(property);
+		free(message);
+	});
+	QObject::connect(&client, &IndigoClient::property_changed, [](indigo_property *property, char *message) {
+		indigo_release_property(property);
+		free(message);
+	});
+	QObject::connect(&client, &IndigoClient::property_deleted, [](indigo_property *property, char *message) {
+		delete property;
+		free(message);
+	});
+	QObject::connect(&client, &IndigoClient::message_sent, [](indigo_property *, char *message) {
+		if (message) indigo_log("%s\n", message);
+		free(message);
+	});
+	QObject::connect(&Logger::instance(), &Logger::do_log, [](indigo_property *, char *message) {
+		if (message) indigo_log("%s\n", message);
+	});
+
+	QServiceModel services("_indigo._tcp");
+	services.enable_auto_connect(true);
+
+	client.enable_blobs(true);
+	client.set_recorder(&recorder);
+	client.start("INDIGO Control Panel");
+	if (conf.archive_history == ARCHIVE_HISTORY_ON) SessionArchive::instance().start(archive_directory().toUtf8().constData());
+	services.start();
+	services.loadManualServices();
+
+	QTimer quit_timer;
+	quit_timer.setInterval(HEADLESS_QUIT_POLL_MS);
+	QObject::connect(&quit_timer, &QTimer::timeout, [&app]() {
+		if (headless_quit_requested) app.quit();
+	});
+	quit_timer.start();
+	signal(SIGINT, headless_quit);
+	signal(SIGTERM, headless_quit);
+	int res = app.exec();
+
+	client.stop();
+	client.set_recorder(nullptr);
+	recorder.stop();
+	SessionArchive::instance().stop();
+	BlobFileNamer::instance().save();
+	TrafficLog::instance().close();
+	return res;
+}
+
+
 int main(int argc, char *argv[]) {
+	startup_timer.start();
 	indigo_main_argv = (const char**)argv;
 	indigo_main_argc = argc;
 
@@ -72,8 +196,20 @@ int main(int argc, char *argv[]) {
 	conf.use_system_locale = false;
 	conf.indigo_log_level = INDIGO_LOG_INFO;
 	conf.preview_stretch_level = STRETCH_NORMAL;
+	conf.tree_refresh_ms = TREE_REFRESH_NORMAL_MS;
+	conf.log_max_lines = LOG_MAX_LINES;
+	strcpy(conf.blob_name_template, BLOB_NAME_TEMPLATE_DEFAULT);
+	conf.blob_sync = BLOB_SYNC_BATCH;
+	conf.archive_history = ARCHIVE_HISTORY_ON;
 	read_conf();
 
+	/* Fields added later are zero in configs written by older versions */
+	if (conf.tree_refresh_ms <= 0) conf.tree_refresh_ms = TREE_REFRESH_NORMAL_MS;
+	if (conf.log_max_lines <= 0) conf.log_max_lines = LOG_MAX_LINES;
+	if (!BlobFileNamer::valid_template(conf.blob_name_template)) strcpy(conf.blob_name_template, BLOB_NAME_TEMPLATE_DEFAULT);
+	if (conf.blob_sync == 0) conf.blob_sync = BLOB_SYNC_BATCH;
+	if (conf.archive_history == 0) conf.archive_history = ARCHIVE_HISTORY_ON;
+
 	if (!conf.use_system_locale) qunsetenv("LC_NUMERIC");
 
 	indigo_set_log_level(conf.indigo_log_level);
@@ -81,6 +217,13 @@ int main(int argc, char *argv[]) {
 	/* This shall be set only before connecting */
 	indigo_use_host_suffix = conf.indigo_use_host_suffix;
 
+	bool headless = false;
+	const char *record_dir = ".";
+	const char *traffic_file = nullptr;
+	const char *replay_file = nullptr;
+	double replay_speed = 1;
+	const char *dump_file = nullptr;
+	double dump_from = 0, dump_to = 0;
 	for (int i = 1; i < argc; i++) {
 		if ((!strcmp(argv[i], "-T") || !strcmp(argv[i], "--master-token")) && i < argc - 1) {
 			indigo_set_master_token(indigo_string_to_token(argv[i + 1]));
@@ -88,8 +231,39 @@ int main(int argc, char *argv[]) {
 		} else if ((!strcmp(argv[i], "-a") || !strcmp(argv[i], "--acl-file")) && i < argc - 1) {
 			indigo_load_device_tokens_from_file(argv[i + 1]);
 			i++;
+		} else if (!strcmp(argv[i], "--startup-trace")) {
+			startup_trace_enabled = true;
+		} else if (!strcmp(argv[i], "--headless")) {
+			headless = true;
+		} else if (!strcmp(argv[i], "--record-dir") && i < argc - 1) {
+			record_dir = argv[i + 1];
+			i++;
+		} else if (!strcmp(argv[i], "--record-traffic") && i < argc - 1) {
+			traffic_file = argv[i + 1];
+			i++;
+		} else if (!strcmp(argv[i], "--replay") && i < argc - 1) {
+			replay_file = argv[i + 1];
+			i++;
+		} else if (!strcmp(argv[i], "--replay-speed") && i < argc - 1) {
+			/* 0 plays as fast as the GUI takes it */
+			replay_speed = atof(argv[i + 1]);
+			i++;
+		} else if (!strcmp(argv[i], "--dump-archive") && i < argc - 1) {
+			dump_file = argv[i + 1];
+			i++;
+		} else if (!strcmp(argv[i], "--dump-range") && i < argc - 2) {
+			/* seconds since the session start, 0 as the end dumps to the end */
+			dump_from = atof(argv[i + 1]);
+			dump_to = atof(argv[i + 2]);
+			i += 2;
 		}
 	}
+	if (dump_file) return dump_archive(dump_file, dump_from, dump_to);
+	if (traffic_file && !TrafficLog::instance().open(traffic_file)) return 1;
+	if (replay_file && !ReplayServer::instance().open(replay_file, replay_speed)) return 1;
+	startup_trace("config loaded");
+
+	if (headless) return run_headless(argc, argv, record_dir);
 
 	QCoreApplication::setAttribute(Qt::AA_EnableHighDpiScaling);
 	QApplication app(argc, argv);
@@ -99,9 +273,18 @@ int main(int argc, char *argv[]) {
 	QTextStream ts(&f);
 	app.setStyleSheet(ts.readAll());
 	f.close();
+	startup_trace("application created");
 
 	BrowserWindow browser_window;
 	browser_window.show();
+	startup_trace("window shown");
 
-	return app.exec();
+	int res = app.exec();
+	ReplayServer::instance().stop();
+	SessionArchive::instance().stop();
+	TrafficLog::instance().close();
+	LivePreview::instance().stop();
+	BlobRecorder::instance().stop();
+	BlobFileNamer::instance().save();
+	return res;
 }
@@ -0,0 +1,87 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <stdlib.h>
+#include <new>
+
+/* Nodes per slab, slabs are allocated as needed and kept for reuse */
+#define NODE_POOL_SLAB 256
+
+/* Fixed size allocator for the property tree nodes. Nodes of one type are
+   carved from contiguous slabs, so a device's groups and properties sit
+   close together and defining a large driver costs a few mallocs instead
+   of one per node. Freed nodes go to a free list. Not thread safe, the
+   tree is only touched from the GUI thread.
+*/
+template <class T>
+class NodePool {
+public:
+	static void* allocate() {
+		if (free_list == nullptr) grow();
+		slot *node = free_list;
+		free_list = node->next;
+		return node;
+	}
+
+	static void release(void *node) {
+		if (node == nullptr) return;
+		slot *s = static_cast<slot*>(node);
+		s->next = free_list;
+		free_list = s;
+	}
+
+private:
+	union slot {
+		slot *next;
+		alignas(T) char storage[sizeof(T)];
+	};
+
+	static void grow() {
+		slot *slab = static_cast<slot*>(malloc(NODE_POOL_SLAB * sizeof(slot)));
+		if (slab == nullptr) throw std::bad_alloc();
+		for (int i = 0; i < NODE_POOL_SLAB - 1; i++) slab[i].next = &slab[i + 1];
+		slab[NODE_POOL_SLAB - 1].next = free_list;
+		free_list = slab;
+	}
+
+	static slot *free_list;
+};
+
+template <class T>
+typename NodePool<T>::slot *NodePool<T>::free_list = nullptr;
+
+
+/* Routes new and delete of T through its pool */
+template <class T>
+struct PooledNode {
+	static void* operator new(size_t size) {
+		if (size != sizeof(T)) return ::operator new(size);
+		return NodePool<T>::allocate();
+	}
+
+	static void operator delete(void *node, size_t size) {
+		if (size != sizeof(T)) ::operator delete(node);
+		else NodePool<T>::release(node);
+	}
+};
+
+#endif // NODEPOOL_H
@@ -0,0 +1,171 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include "propertyindex.h"
+
+#define KEY_SEPARATOR QChar('\t')
+#define FIELD_SEPARATOR QChar('\n')
+
+PropertyIndex::PropertyIndex() {
+}
+
+
+QString PropertyIndex::key(const char *device, const char *group, const char *name) {
+	return QString(device) + KEY_SEPARATOR + QString(group) + KEY_SEPARATOR + QString(name);
+}
+
+
+/* The UTF-16 units of a gram are packed 16 bits each, the length goes in the top bits */
+QSet<quint64> PropertyIndex::grams(const QString &field) {
+	QSet<quint64> result;
+	for (int start = 0; start < field.size(); start++) {
+		quint64 gram = 0;
+		for (int length = 1; length <= PROPERTY_INDEX_GRAM && start + length <= field.size(); length++) {
+			gram = (gram << 16) | field[start + length - 1].unicode();
+			result.insert(gram | ((quint64)length << 60));
+		}
+	}
+	return result;
+}
+
+
+void PropertyIndex::add_grams(int id, const QString &field) {
+	for (quint64 gram : grams(field)) m_postings[gram].insert(id);
+}
+
+
+int PropertyIndex::add(indigo_property *property) {
+	QString property_key = key(property->device, property->group, property->name);
+	if (m_by_key.contains(property_key)) return -1;
+
+	QStringList fields;
+	fields << QString(property->device).toCaseFolded()
+	       << QString(property->group).toCaseFolded()
+	       << QString(property->name).toCaseFolded()
+	       << QString(property->label).toCaseFolded();
+	for (int i = 0; i < property->count; i++) {
+		fields << QString(property->items[i].name).toCaseFolded()
+		       << QString(property->items[i].label).toCaseFolded();
+	}
+
+	int id;
+	if (m_free.isEmpty()) {
+		id = m_entries.size();
+		m_entries.append(entry());
+	} else {
+		id = m_free.takeLast();
+	}
+	entry &e = m_entries[id];
+	e.key = property_key;
+	e.device = property->device;
+	e.group = property->group;
+	e.text = fields.join(FIELD_SEPARATOR);
+
+	for (const QString &field : fields) add_grams(id, field);
+	m_by_key.insert(property_key, id);
+	m_by_device[e.device].insert(id);
+	return id;
+}
+
+
+void PropertyIndex::set_rows(int id, const QModelIndex &property, const QModelIndex &group, const QModelIndex &device) {
+	rows &r = m_entries[id].indexes;
+	r.property = property;
+	r.group = group;
+	r.device = device;
+}
+
+
+void PropertyIndex::remove_entry(int id) {
+	entry &e = m_entries[id];
+	for (const QString &field : e.text.split(FIELD_SEPARATOR)) {
+		for (quint64 gram : grams(field)) {
+			auto posting = m_postings.find(gram);
+			if (posting == m_postings.end()) continue;
+			posting->remove(id);
+			if (posting->isEmpty()) m_postings.erase(posting);
+		}
+	}
+	m_by_key.remove(e.key);
+	auto device = m_by_device.find(e.device);
+	if (device != m_by_device.end()) {
+		device->remove(id);
+		if (device->isEmpty()) m_by_device.erase(device);
+	}
+	e = entry();
+	m_free.append(id);
+}
+
+
+void PropertyIndex::remove(const char *device, const char *group, const char *name) {
+	if (name[0] != '\0') {
+		int id = m_by_key.value(key(device, group, name), -1);
+		if (id >= 0) remove_entry(id);
+		return;
+	}
+	QSet<int> ids = m_by_device.value(device);
+	for (int id : ids) {
+		if (group[0] == '\0' || m_entries[id].group == group) remove_entry(id);
+	}
+}
+
+
+void PropertyIndex::clear() {
+	m_entries.clear();
+	m_free.clear();
+	m_by_key.clear();
+	m_by_device.clear();
+	m_postings.clear();
+}
+
+
+QSet<int> PropertyIndex::match(const QString &query) const {
+	QString folded = query.trimmed().toCaseFolded();
+	QSet<int> result;
+	if (folded.isEmpty()) {
+		result.reserve(m_by_key.size());
+		for (int id : m_by_key) result.insert(id);
+		return result;
+	}
+
+	//  The grams of a longer query are covered by its trigrams
+	QVector<const QSet<int>*> postings;
+	int gram_length = qMin(folded.size(), PROPERTY_INDEX_GRAM);
+	for (int start = 0; start + gram_length <= folded.size(); start++) {
+		quint64 gram = 0;
+		for (int i = 0; i < gram_length; i++) gram = (gram << 16) | folded[start + i].unicode();
+		auto posting = m_postings.constFind(gram | ((quint64)gram_length << 60));
+		if (posting == m_postings.constEnd()) return result;
+		postings.append(&posting.value());
+	}
+	std::sort(postings.begin(), postings.end(), [](const QSet<int> *a, const QSet<int> *b) {
+		return a->size() < b->size();
+	});
+
+	for (int id : *postings.first()) {
+		bool candidate = true;
+		for (int i = 1; i < postings.size() && candidate; i++) candidate = postings[i]->contains(id);
+		if (!candidate) continue;
+		//  Grams can match out of order, the text has the final say
+		if (folded.size() <= PROPERTY_INDEX_GRAM || m_entries[id].text.contains(folded))
+			result.insert(id);
+	}
+	return result;
+}
@@ -0,0 +1,92 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef PROPERTYINDEX_H
+#define PROPERTYINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QList>
+#include <QPersistentModelIndex>
+#include <indigo/indigo_bus.h>
+
+/* Longest n-gram indexed, longer queries are verified against the text */
+#define PROPERTY_INDEX_GRAM 3
+
+
+/* Substring search over the names and labels of devices, groups,
+   properties and items. Every property is one entry, its fields are cut
+   into 1 to PROPERTY_INDEX_GRAM long case folded n-grams, each with the
+   set of entries containing it. A query intersects the sets of its
+   n-grams, smallest first, and checks the few candidates left, so it never
+   looks at the tree. The index is updated as properties come and go.
+
+   Entries are known by their id, which is reused after the entry is
+   removed. Each entry keeps persistent indexes of its property row and
+   of the group and device rows above it, set once the rows exist.
+*/
+class PropertyIndex {
+public:
+	PropertyIndex();
+
+	struct rows {
+		QPersistentModelIndex property;
+		QPersistentModelIndex group;
+		QPersistentModelIndex device;
+	};
+
+	/* Id of the new entry, -1 if the property is already there */
+	int add(indigo_property *property);
+	void set_rows(int id, const QModelIndex &property, const QModelIndex &group, const QModelIndex &device);
+	/* an empty name removes the whole group, an empty group the whole device */
+	void remove(const char *device, const char *group, const char *name);
+	void clear();
+
+	/* Ids of the properties matching query */
+	QSet<int> match(const QString &query) const;
+	QList<int> ids() const { return m_by_key.values(); }
+	const rows& rows_of(int id) const { return m_entries[id].indexes; }
+	int size() const { return m_by_key.size(); }
+
+	static QString key(const char *device, const char *group, const char *name);
+
+private:
+	struct entry {
+		QString key;
+		QString device;
+		QString group;
+		QString text;
+		rows indexes;
+	};
+
+	void add_grams(int id, const QString &field);
+	void remove_entry(int id);
+	static QSet<quint64> grams(const QString &field);
+
+	QVector<entry> m_entries;
+	QVector<int> m_free;
+	QHash<QString, int> m_by_key;
+	QHash<QString, QSet<int>> m_by_device;
+	QHash<quint64, QSet<int>> m_postings;
+};
+
+#endif // PROPERTYINDEX_H
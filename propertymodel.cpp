@@ -22,16 +22,33 @@
 #include <QLineEdit>
 #include <QCheckBox>
 #include <unistd.h>
+#include <algorithm>
+#include <QSet>
 #include "blobpreview.h"
 #include "propertymodel.h"
 #include "qindigoproperty.h"
+#include "iconcache.h"
+#include "stats.h"
+#include "history.h"
 #include <indigo/indigo_names.h>
 #include "conf.h"
 
 extern indigo_client client;
 
+/* Nodes of each type are counted in the stats, the root is not */
+static void count_node(enum TreeNodeType type, int delta) {
+	if (type != TREE_NODE_ROOT) Stats::instance().add((stat_counter)(STAT_TREE_DEVICES + type - TREE_NODE_DEVICE), delta);
+}
+
+
+TreeNode::TreeNode(enum TreeNodeType type) : node_type(type) {
+	count_node(type, 1);
+}
+
+
 TreeNode::~TreeNode() {
 	indigo_debug("CALLED: %s on %p\n", __FUNCTION__, this);
+	count_node(node_type, -1);
 }
 
 
@@ -47,110 +64,245 @@ GroupNode::~GroupNode() {
 }
 
 
+PropertyNode::PropertyNode(indigo_property* p, GroupNode* parent) : TreeNodeWithParent(TREE_NODE_PROPERTY, parent), property(p) {
+	Stats::instance().add(STAT_TREE_ITEMS, property->count);
+}
+
+
 PropertyNode::~PropertyNode() {
 	indigo_debug("CALLED: %s on %p\n", __FUNCTION__, this);
 	if (property) {
+		Stats::instance().add(STAT_TREE_ITEMS, -property->count);
+		History::instance().remove(property);
 		indigo_release_property(property);
 		property = nullptr;
 	}
 }
 
 
-ItemNode::ItemNode(indigo_item* i, PropertyNode* parent) : TreeNodeWithParent<PropertyNode>(TREE_NODE_ITEM, parent), item(i) {
-	input_control = nullptr;
-}
-
-
-ItemNode::~ItemNode() {
-	indigo_debug("CALLED: %s\n", __FUNCTION__);
-}
-
 RootNode::~RootNode() {
 	indigo_debug("CALLED: %s\n", __FUNCTION__);
 }
 
 PropertyModel::PropertyModel() {
 	no_repaint_flag = false;
+	m_refresh_timer.setSingleShot(true);
+	m_refresh_timer.setInterval(conf.tree_refresh_ms);
+	connect(&m_refresh_timer, &QTimer::timeout, this, &PropertyModel::flush_dirty_rows);
+	m_define_timer.setSingleShot(true);
+	m_define_timer.setInterval(TREE_DEFINE_BATCH_MS);
+	connect(&m_define_timer, &QTimer::timeout, this, &PropertyModel::flush_pending_defines);
+	//  Index changes are announced once per event loop pass
+	m_search_timer.setSingleShot(true);
+	m_search_timer.setInterval(0);
+	connect(&m_search_timer, &QTimer::timeout, this, &PropertyModel::search_index_changed);
 	indigo_debug("CALLED: %s\n", __FUNCTION__);
 }
 
 
+void PropertyModel::set_refresh_interval(int msec) {
+	m_refresh_timer.setInterval(msec);
+}
+
+
+void PropertyModel::mark_dirty_row(TreeNode* parent, int row) {
+	auto i = m_dirty_rows.find(parent);
+	if (i == m_dirty_rows.end()) {
+		m_dirty_rows.insert(parent, qMakePair(row, row));
+	} else {
+		if (row < i.value().first) i.value().first = row;
+		if (row > i.value().second) i.value().second = row;
+	}
+	//  The timer is not restarted, so the tree is refreshed at most once per interval
+	if (!m_refresh_timer.isActive()) m_refresh_timer.start();
+}
+
+
+/* The list only drops the pointer, the node (and its subtree) goes back
+   to its pool here. Rows must be removed and the delete reported first.
+*/
+void PropertyModel::release_node(TreeNode* node) {
+	emit(node_removed(node));
+	delete node;
+}
+
+
+void PropertyModel::flush_dirty_rows() {
+	m_refresh_timer.stop();
+	for (auto i = m_dirty_rows.constBegin(); i != m_dirty_rows.constEnd(); ++i) {
+		TreeNode* parent = i.key();
+		int first = i.value().first;
+		int last = qMin(i.value().second, parent->size() - 1);
+		if (first > last) continue;
+		emit(dataChanged(createIndex(first, 0, (*parent)[first]), createIndex(last, 0, (*parent)[last])));
+	}
+	m_dirty_rows.clear();
+}
+
+
 void PropertyModel::define_property(indigo_property* property, char *message) {
-	//  Find or create TreeNode for property->device
-	//indigo_debug("Defining device [%s],  group [%s],  property [%s]\n", property->device, property->group, property->name);
-	int device_row = 0;
-	DeviceNode* device = root.children.find_by_name_with_index(property->device, device_row);
-	if (device == nullptr) {
-		//  Insert the device in alphabetical order
-		device = new DeviceNode(property->device, &root);
+	Stats::instance().add(STAT_QUEUED_SIGNALS, -1);
+	//  The message is logged and freed by the window
+	Q_UNUSED(message);
 
-		no_repaint_flag = true;
-		device_row = root.children.find_insertion_index_by_label(property->device);
-		beginInsertRows(QModelIndex(), device_row, device_row);
-		root.children.insert_at(device_row, device);
-		endInsertRows();
-		no_repaint_flag = false;
+	m_pending_defines.append(property);
+	//  The timer is not restarted, a long burst is still shown in steps
+	if (!m_define_timer.isActive()) m_define_timer.start();
+}
+
+
+template <class T>
+static T* find_node(const QList<T*> &nodes, const char *name) {
+	for (T* node : nodes) {
+		if (strcmp(node->name(), name) == 0) return node;
 	}
+	return nullptr;
+}
 
-	//  Find or create TreeNode within device for property->group
-	int group_row = 0;
-	GroupNode* group = device->children.find_by_name_with_index(property->group, group_row);
-	if (group == nullptr) {
-		//  Insert the group in alphabetical order
-		group = new GroupNode(property->group, device);
 
-		no_repaint_flag = true;
-		group_row = device->children.find_insertion_index_by_label(property->group);
-		beginInsertRows(createIndex(device_row, 0, device), group_row, group_row);
-		device->children.insert_at(group_row, group);
-		endInsertRows();
-		no_repaint_flag = false;
+static void update_device_node(DeviceNode* device, indigo_property* property) {
+	//  If this is a CONNECTION property - copy status to device node
+	if (strcmp(property->name, CONNECTION_PROPERTY_NAME) == 0) {
+		if (property->items[0].sw.value)
+			device->state = INDIGO_OK_STATE;
+		else
+			device->state = INDIGO_IDLE_STATE;
+	}
+	// Change device icon according the device intrface
+	if (strcmp(property->name, INFO_PROPERTY_NAME) == 0) {
+		for (int i = 0; i < property->count; ++i) {
+			if (strcmp(property->items[i].name, INFO_DEVICE_INTERFACE_ITEM_NAME) == 0) {
+				device->m_interface = atoi(property->items[i].text.value);
+				device->m_icon = device_icon_for_interface(device->m_interface);
+				indigo_debug("Device interface [%s] = %04x\n",device->name(), device->m_interface);
+				break;
+			}
+		}
 	}
+}
 
-	//  Find or create TreeNode within group for property->name
-	int property_row = 0;
-	PropertyNode* p = group->children.find_by_name_with_index(property->name, property_row);
-	if (p == nullptr) {
-		//  Insert the property in alphabetical order
-		p = new PropertyNode(property, group);
 
-		no_repaint_flag = true;
-		property_row = group->children.find_insertion_index_by_label(property->label);
-		beginInsertRows(createIndex(group_row, 0, group), property_row, property_row);
-		group->children.insert_at(property_row, p);
+/* nodes are sorted by label, the ones going to the same place are inserted together */
+template <class ChildT>
+void PropertyModel::insert_runs(const QModelIndex &parent, OrderedList<ChildT> &children, const QList<ChildT*> &nodes) {
+	int i = 0;
+	while (i < nodes.size()) {
+		int at = children.find_insertion_index_by_label(nodes[i]->label());
+		int end = i + 1;
+		while (end < nodes.size() && children.find_insertion_index_by_label(nodes[end]->label()) == at) end++;
+
+		beginInsertRows(parent, at, at + end - i - 1);
+		for (int n = i; n < end; n++) children.insert_at(at + n - i, nodes[n]);
 		endInsertRows();
-		no_repaint_flag = false;
+		i = end;
+	}
+}
+
 
-		//  Create the ItemNodes
-		for (int i = 0; i < property->count; i++) {
-			ItemNode* item = new ItemNode(&property->items[i], p);
-			p->children.insert_at(i, item);
+void PropertyModel::flush_pending_defines() {
+	m_define_timer.stop();
+	if (m_pending_defines.isEmpty()) return;
+
+	//  Pending row changes must be reported before rows are shifted
+	if (!m_dirty_rows.isEmpty()) flush_dirty_rows();
+
+	QList<indigo_property*> pending;
+	pending.swap(m_pending_defines);
+	std::stable_sort(pending.begin(), pending.end(), [](indigo_property* a, indigo_property* b) {
+		int order = strcmp(a->device, b->device);
+		if (order == 0) order = strcmp(a->group, b->group);
+		if (order == 0) order = strcmp(a->label, b->label);
+		return order < 0;
+	});
+
+	//  Build the new nodes off the tree first, nodes in detached are not
+	//  visible yet and get their children without any row signals
+	QList<DeviceNode*> new_devices;
+	QHash<DeviceNode*, QList<GroupNode*>> new_groups;
+	QHash<GroupNode*, QList<PropertyNode*>> new_properties;
+	QSet<TreeNode*> detached;
+	QList<indigo_property*> defined;
+	QList<QPair<int, PropertyNode*>> indexed;
+
+	for (indigo_property* property : pending) {
+		//indigo_debug("Defining device [%s],  group [%s],  property [%s]\n", property->device, property->group, property->name);
+		DeviceNode* device = root.children.find_by_name(property->device);
+		if (device == nullptr) device = find_node(new_devices, property->device);
+		if (device == nullptr) {
+			device = new DeviceNode(property->device, &root);
+			new_devices.append(device);
+			detached.insert(device);
 		}
 
-		//  If this is a CONNECTION property - copy status to device node
-		if (strcmp(property->name, CONNECTION_PROPERTY_NAME) == 0) {
-			if (property->items[0].sw.value)
-				device->state = INDIGO_OK_STATE;
+		GroupNode* group = device->children.find_by_name(property->group);
+		if (group == nullptr && !detached.contains(device)) group = find_node(new_groups.value(device), property->group);
+		if (group == nullptr) {
+			group = new GroupNode(property->group, device);
+			if (detached.contains(device))
+				device->children.insert_at(device->children.find_insertion_index_by_label(property->group), group);
 			else
-				device->state = INDIGO_IDLE_STATE;
+				new_groups[device].append(group);
+			detached.insert(group);
 		}
-		// Change device icon according the device intrface
-		if (strcmp(property->name, INFO_PROPERTY_NAME) == 0) {
-			for (int i = 0; i < property->count; ++i) {
-				if (strcmp(property->items[i].name, INFO_DEVICE_INTERFACE_ITEM_NAME) == 0) {
-					device->m_interface = atoi(property->items[i].text.value);
-					indigo_debug("Device interface [%s] = %04x\n",device->name(), device->m_interface);
-					break;
-				}
-			}
+
+		PropertyNode* p = group->children.find_by_name(property->name);
+		if (p == nullptr && !detached.contains(group)) p = find_node(new_properties.value(group), property->name);
+		if (p != nullptr) {
+			//  Already defined, the copy is not needed
+			indigo_release_property(property);
+			continue;
 		}
-		emit(property_defined(property, message));
+		p = new PropertyNode(property, group);
+		if (detached.contains(group))
+			group->children.insert_at(group->children.find_insertion_index_by_label(property->label), p);
+		else
+			new_properties[group].append(p);
+
+		//  Items are shown by the property forms, the tree has no nodes for them
+		update_device_node(device, property);
+		int id = m_search_index.add(property);
+		if (id >= 0) indexed.append(qMakePair(id, p));
+		defined.append(property);
+	}
+
+	no_repaint_flag = true;
+	for (auto i = new_properties.constBegin(); i != new_properties.constEnd(); ++i) {
+		GroupNode* group = i.key();
+		DeviceNode* device = group->m_parent;
+		insert_runs(createIndex(device->children.index_of(group), 0, group), group->children, i.value());
+	}
+	for (auto i = new_groups.constBegin(); i != new_groups.constEnd(); ++i) {
+		DeviceNode* device = i.key();
+		insert_runs(createIndex(root.children.index_of(device), 0, device), device->children, i.value());
+	}
+	insert_runs(QModelIndex(), root.children, new_devices);
+	no_repaint_flag = false;
+
+	//  The rows exist now, the filter keeps persistent indexes of them
+	for (auto i = indexed.constBegin(); i != indexed.constEnd(); ++i) {
+		PropertyNode* p = i->second;
+		GroupNode* group = p->m_parent;
+		DeviceNode* device = group->m_parent;
+		m_search_index.set_rows(i->first,
+			createIndex(group->children.index_of(p), 0, p),
+			createIndex(device->children.index_of(group), 0, group),
+			createIndex(root.children.index_of(device), 0, device));
 	}
-	//indigo_debug("Defined device [%s],  group [%s],  property [%s]\n", property->device, property->group, property->name);
+
+	//  Existing devices may have changed state or icon
+	for (auto i = new_groups.constBegin(); i != new_groups.constEnd(); ++i) mark_dirty_row(&root, root.children.index_of(i.key()));
+	for (auto i = new_properties.constBegin(); i != new_properties.constEnd(); ++i) mark_dirty_row(&root, root.children.index_of(i.key()->m_parent));
+
+	for (indigo_property* property : defined) emit(property_defined(property, nullptr));
+	if (!defined.isEmpty() && !m_search_timer.isActive()) m_search_timer.start();
+	indigo_debug("Defined %d properties in one batch\n", defined.size());
 }
 
 
 void PropertyModel::update_property(indigo_property* property, char *message) {
+	Stats::instance().add(STAT_QUEUED_SIGNALS, -1);
+	if (!m_pending_defines.isEmpty()) flush_pending_defines();
+
 	//  Find TreeNode for property->device
 	int device_row = 0;
 	DeviceNode* device = root.children.find_by_name_with_index(property->device, device_row);
@@ -171,13 +323,14 @@ void PropertyModel::update_property(indigo_property* property, char *message) {
 	//  Update property
 	p->property->state = property->state;
 	memcpy(p->property->items, property->items, sizeof(indigo_item) * property->count);
+	History::instance().record(p->property);
 
 	//  If there is a property widget attached, update it
+	dispatch_update(p->property);
 	emit(property_updated(p->property, message));
 
-	//  Emit a data changed signal so the tree can update (mainly for status LEDs)
-	QModelIndex index = createIndex(row, 0, p);
-	emit(dataChanged(index, index));
+	//  Let the tree update (mainly for status LEDs) with the next refresh
+	mark_dirty_row(group, row);
 
 	//  If its a CONNECTION property - update device node also
 	if (strcmp(property->name, CONNECTION_PROPERTY_NAME) == 0) {
@@ -186,15 +339,60 @@ void PropertyModel::update_property(indigo_property* property, char *message) {
 		else
 			device->state = INDIGO_IDLE_STATE;
 
-		QModelIndex index = createIndex(device_row, 0, device);
-		emit(dataChanged(index, index));
+		mark_dirty_row(&root, device_row);
 	}
 	indigo_release_property(property);
 }
 
+void PropertyModel::attach_widget(QIndigoProperty* widget) {
+	indigo_property* property = widget->get_property();
+	m_property_widgets.insert(property, widget);
+	connect(widget, &QObject::destroyed, this, [this, property, widget]() {
+		m_property_widgets.remove(property, widget);
+	});
+}
+
+
+void PropertyModel::detach_widget(QIndigoProperty* widget) {
+	m_property_widgets.remove(widget->get_property(), widget);
+}
+
+
+void PropertyModel::restyle_widgets() {
+	for (auto i = m_property_widgets.constBegin(); i != m_property_widgets.constEnd(); ++i) {
+		i.value()->restyle();
+	}
+}
+
+
+void PropertyModel::dispatch_update(indigo_property* property) {
+	//  Only the widgets bound to this property are called
+	auto i = m_property_widgets.constFind(property);
+	while (i != m_property_widgets.constEnd() && i.key() == property) {
+		i.value()->property_update(property);
+		++i;
+	}
+}
+
+
+/* Removed nodes are not freed, the histories of their properties are dropped here */
+static void remove_history(GroupNode* group) {
+	for (int i = 0; i < group->children.count; i++) History::instance().remove(group->children.nodes[i]->property);
+}
+
+
 void PropertyModel::delete_property(indigo_property* property, char *message) {
+	Stats::instance().add(STAT_QUEUED_SIGNALS, -1);
+	if (!m_pending_defines.isEmpty()) flush_pending_defines();
 	indigo_debug("Deleting property [%s] on device [%s]\n", property->name, property->device);
 
+	//  The filter is applied again once the rows are gone
+	m_search_index.remove(property->device, property->group, property->name);
+	if (!m_search_timer.isActive()) m_search_timer.start();
+
+	//  Pending row changes must be reported before rows are removed
+	if (!m_dirty_rows.isEmpty()) flush_dirty_rows();
+
 	//  Find TreeNode for property->device
 	int device_row = 0;
 	DeviceNode* device = root.children.find_by_name_with_index(property->device, device_row);
@@ -208,11 +406,13 @@ void PropertyModel::delete_property(indigo_property* property, char *message) {
 
 	//  If we are deleting whole device - do that
 	if ((property) && (strlen(property->group) == 0)) {
+		for (int i = 0; i < device->children.count; i++) remove_history(device->children.nodes[i]);
 		no_repaint_flag = true;
 		beginRemoveRows(QModelIndex(), device_row, device_row);
 		root.children.remove_index(device_row);
 		endRemoveRows();
 		emit(property_deleted(property, message));
+		release_node(device);
 		delete property;
 		no_repaint_flag = false;
 		return;
@@ -231,11 +431,13 @@ void PropertyModel::delete_property(indigo_property* property, char *message) {
 
 	//  If we are deleting whole group - do that
 	if (strlen(property->name) == 0) {
+		remove_history(group);
 		no_repaint_flag = true;
 		beginRemoveRows(createIndex(device_row, 0, device), group_row, group_row);
 		device->children.remove_index(group_row);
 		endRemoveRows();
 		emit(property_deleted(property, message));
+		release_node(group);
 		delete property;
 		no_repaint_flag = false;
 		return;
@@ -253,6 +455,7 @@ void PropertyModel::delete_property(indigo_property* property, char *message) {
 	}
 
 	//  Remove the property
+	History::instance().remove(p->property);
 	no_repaint_flag = true;
 	indigo_debug("Erasing property [%s] in %p %p\n", property->name, device, group);
 	beginRemoveRows(createIndex(group_row, 0, group), property_row, property_row);
@@ -267,6 +470,7 @@ void PropertyModel::delete_property(indigo_property* property, char *message) {
 	strcpy(groupname, property->group);
 
 	//  Remove the group if empty
+	bool group_removed = false;
 	if (group->children.empty()) {
 		indigo_debug("--- REMOVING EMPTY GROUP %p -> [%s]\n", group, groupname);
 		no_repaint_flag = true;
@@ -274,10 +478,12 @@ void PropertyModel::delete_property(indigo_property* property, char *message) {
 		device->children.remove_index(group_row);
 		endRemoveRows();
 		no_repaint_flag = false;
+		group_removed = true;
 		indigo_debug("--- REMOVED EMPTY GROUP [%s]\n", groupname);
 	}
 
 	//  Remove the device if empty
+	bool device_removed = false;
 	if (device->children.empty()) {
 		indigo_debug("--- REMOVING EMPTY DEVICE %p -> [%s]\n", device, devname);
 		no_repaint_flag = true;
@@ -285,10 +491,16 @@ void PropertyModel::delete_property(indigo_property* property, char *message) {
 		root.children.remove_index(device_row);
 		endRemoveRows();
 		no_repaint_flag = false;
+		device_removed = true;
 		indigo_debug("--- REMOVED EMPTY DEVICE [%s]\n", devname);
 	}
 	emit(property_deleted(property, message));
 
+	//  Nodes are freed only after everybody has seen the delete
+	release_node(p);
+	if (group_removed) release_node(group);
+	if (device_removed) release_node(device);
+
 	delete property;
 }
 
@@ -360,176 +572,10 @@ QVariant PropertyModel::data(const QModelIndex &index, int role) const {
 		case Qt::DecorationRole: {
 			if (node->node_type == TREE_NODE_PROPERTY) {
 				PropertyNode* p = reinterpret_cast<PropertyNode*>(node);
-				switch (p->property->state) {
-				case INDIGO_IDLE_STATE:
-					return QPixmap(":resource/led-grey.png");
-				case INDIGO_BUSY_STATE:
-					if (conf.use_state_icons)
-						return QPixmap(":resource/led-orange-cb.png");
-					else
-						return QPixmap(":resource/led-orange.png");
-				case INDIGO_ALERT_STATE:
-					if (conf.use_state_icons)
-						return QPixmap(":resource/led-red-cb.png");
-					else
-						return QPixmap(":resource/led-red.png");
-				case INDIGO_OK_STATE:
-					if (conf.use_state_icons)
-						return QPixmap(":resource/led-green-cb.png");
-					else
-						return QPixmap(":resource/led-green.png");
-				}
+				return IconCache::instance().state_led(p->property->state, conf.use_state_icons);
 			} else if (node->node_type == TREE_NODE_DEVICE) {
 				DeviceNode* d = reinterpret_cast<DeviceNode*>(node);
-				if (d->m_interface & INDIGO_INTERFACE_CCD) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/ccd-green.png");
-					default:
-						return QPixmap(":resource/ccd-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_MOUNT) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/mount-green.png");
-					default:
-						return QPixmap(":resource/mount-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_GUIDER) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/guider-green.png");
-					default:
-						return QPixmap(":resource/guider-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_GPS) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/gps-green.png");
-					default:
-						return QPixmap(":resource/gps-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_WHEEL) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/wheel-green.png");
-					default:
-						return QPixmap(":resource/wheel-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_FOCUSER) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/focuser-green.png");
-					default:
-						return QPixmap(":resource/focuser-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_AO) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/ao-green.png");
-					default:
-						return QPixmap(":resource/ao-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_DOME) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/dome-green.png");
-					default:
-						return QPixmap(":resource/dome-grey.png");
-					}
-				}
-				if (d->m_interface & INDIGO_INTERFACE_ROTATOR) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/rotator-green.png");
-					default:
-						return QPixmap(":resource/rotator-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_POWERBOX & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/powerbox-green.png");
-					default:
-						return QPixmap(":resource/powerbox-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_WEATHER & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/weather-green.png");
-					default:
-						return QPixmap(":resource/weather-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_JOYSTICK & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/joystick-green.png");
-					default:
-						return QPixmap(":resource/joystick-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_SHUTTER & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/shutter-green.png");
-					default:
-						return QPixmap(":resource/shutter-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_SQM & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/sqm-green.png");
-					default:
-						return QPixmap(":resource/sqm-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_LIGHTBOX & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/flatbox-green.png");
-					default:
-						return QPixmap(":resource/flatbox-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_DUSTCAP & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/dustcap-green.png");
-					default:
-						return QPixmap(":resource/dustcap-grey.png");
-					}
-				}
-				if ((d->m_interface & INDIGO_INTERFACE_AUX) && (d->m_interface & INDIGO_INTERFACE_AUX_GPIO & ~INDIGO_INTERFACE_AUX)) {
-					switch (d->state) {
-					case INDIGO_OK_STATE:
-						return QPixmap(":resource/gpio-green.png");
-					default:
-						return QPixmap(":resource/gpio-grey.png");
-					}
-				}
-				if (d->m_interface == 0) { // server
-						return QPixmap(":resource/server.png");
-				}
-				switch (d->state) {
-				case INDIGO_IDLE_STATE:
-					return QPixmap(":resource/led-grey-dev.png");
-				case INDIGO_BUSY_STATE:
-					return QPixmap(":resource/led-orange.png");
-				case INDIGO_ALERT_STATE:
-					return QPixmap(":resource/led-red.png");
-				case INDIGO_OK_STATE:
-					return QPixmap(":resource/led-green-dev.png");
-				}
+				return IconCache::instance().device_icon(d->m_icon, d->state);
 			} else {
 				return QVariant();
 			}
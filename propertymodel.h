@@ -21,16 +21,23 @@
 #define PROPERTYMODEL_H
 
 #include <QAbstractItemModel>
+#include <QMultiHash>
+#include <QHash>
+#include <QPair>
+#include <QList>
+#include <QTimer>
 #include <QLabel>
 #include <indigo/indigo_bus.h>
 #include <assert.h>
+#include "iconcache.h"
+#include "nodepool.h"
+#include "propertyindex.h"
 
 enum TreeNodeType {
 	TREE_NODE_ROOT,
 	TREE_NODE_DEVICE,
 	TREE_NODE_GROUP,
-	TREE_NODE_PROPERTY,
-	TREE_NODE_ITEM
+	TREE_NODE_PROPERTY
 };
 
 class QIndigoProperty;
@@ -38,9 +45,8 @@ class QIndigoProperty;
 template <class T>
 class OrderedList {
 public:
-	OrderedList() : count(0), max(1) {
-		nodes = reinterpret_cast<T**>(malloc(sizeof(T*)));
-	}
+	//  The array is allocated with the first node, most item lists stay empty
+	OrderedList() : nodes(nullptr), count(0), max(0) {}
 
 	~OrderedList() {
 		//  Delete the contents of the array
@@ -104,7 +110,7 @@ public:
 	void insert_at(int index, T* node) {
 		//  Ensure we have enough space
 		if (count + 1 > max) {
-			max *= 2;
+			max = max ? max * 2 : 4;
 			nodes = reinterpret_cast<T**>(realloc(nodes, max * sizeof(T*)));
 		}
 
@@ -129,7 +135,7 @@ public:
 };
 
 struct TreeNode {
-	TreeNode(enum TreeNodeType type) : node_type(type) {}
+	TreeNode(enum TreeNodeType type);
 	virtual ~TreeNode();
 
 	virtual int size() const { return 0; }
@@ -170,13 +176,13 @@ struct RootNode;
 struct DeviceNode;
 struct GroupNode;
 struct PropertyNode;
-struct ItemNode;
 
 
-struct DeviceNode : public TreeNodeWithChildren<RootNode,GroupNode> {
+struct DeviceNode : public TreeNodeWithChildren<RootNode,GroupNode>, public PooledNode<DeviceNode> {
 	DeviceNode(const char* device_name, RootNode* parent) : TreeNodeWithChildren<RootNode,GroupNode>(TREE_NODE_DEVICE, parent), state(INDIGO_IDLE_STATE) {
 		strncpy(m_name, device_name, sizeof(m_name));
 		m_interface = 0;
+		m_icon = DEVICE_ICON_SERVER;
 	}
 
 	virtual ~DeviceNode();
@@ -186,11 +192,12 @@ struct DeviceNode : public TreeNodeWithChildren<RootNode,GroupNode> {
 
 	char m_name[INDIGO_NAME_SIZE];
 	int m_interface;
+	device_icon_type m_icon;
 	indigo_property_state state;   //  This could instead be a pointer to the connection property of the device
 };
 
 
-struct GroupNode : public TreeNodeWithChildren<DeviceNode,PropertyNode> {
+struct GroupNode : public TreeNodeWithChildren<DeviceNode,PropertyNode>, public PooledNode<GroupNode> {
 	GroupNode(const char* group_name, DeviceNode* parent) : TreeNodeWithChildren(TREE_NODE_GROUP, parent) {
 		strncpy(m_name, group_name, sizeof(m_name));
 		strncpy(m_device, parent->name(), sizeof(m_device));
@@ -207,32 +214,20 @@ struct GroupNode : public TreeNodeWithChildren<DeviceNode,PropertyNode> {
 };
 
 
-struct PropertyNode : public TreeNodeWithChildren<GroupNode,ItemNode> {
+/* The tree stops at properties, their items are only counted in the stats */
+struct PropertyNode : public TreeNodeWithParent<GroupNode>, public PooledNode<PropertyNode> {
 public:
-	PropertyNode(indigo_property* p, GroupNode* parent) : TreeNodeWithChildren(TREE_NODE_PROPERTY, parent), property(p) {}
+	PropertyNode(indigo_property* p, GroupNode* parent);
 	virtual ~PropertyNode();
 
 	virtual const char* device() { return property->device; }
 	virtual const char* group() { return property->group; }
 	virtual const char* name() { return property->name; }
 	virtual const char* label() { return property->label; }
-	virtual int size() const { return 0; }
 
 	indigo_property* property;
 };
 
-struct ItemNode : public TreeNodeWithParent<PropertyNode> {
-public:
-	ItemNode(indigo_item* i, PropertyNode* parent);
-	virtual ~ItemNode();
-
-	virtual const char* name() { return item->name; }
-	virtual const char* label() { return item->label; }
-
-	QWidget* input_control;
-	indigo_item* item;
-};
-
 
 struct RootNode : public TreeNodeWithChildren<TreeNode,DeviceNode> {
 	RootNode() : TreeNodeWithChildren(TREE_NODE_ROOT, nullptr) {}
@@ -256,10 +251,24 @@ public:
 	int columnCount(const QModelIndex &parent = QModelIndex()) const;
 	QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const;
 
+	/* Property widgets attached here get updates for their property only.
+	   Widgets are detached automatically when destroyed.
+	*/
+	void attach_widget(QIndigoProperty* widget);
+	void detach_widget(QIndigoProperty* widget);
+	/* Attached widgets show their state again, e.g. with other icons */
+	void restyle_widgets();
+
+	/* Names and labels of everything in the tree, for the filter box */
+	const PropertyIndex& search_index() const { return m_search_index; }
+
 signals:
 	void property_updated(indigo_property* property, char *message);
 	void property_defined(indigo_property* property, char *message);
 	void property_deleted(indigo_property* property, char *message);
+	void search_index_changed();
+	/* Emitted just before a node removed from the tree is freed */
+	void node_removed(TreeNode* node);
 
 public slots:
 	void define_property(indigo_property* property, char *message);
@@ -267,9 +276,39 @@ public slots:
 	void delete_property(indigo_property* property, char *message);
 	void enable_blobs(bool on);
 	void rebuild_blob_previews();
+	void set_refresh_interval(int msec);
+
+private slots:
+	void flush_dirty_rows();
+	void flush_pending_defines();
 
 private:
 	RootNode root;
+
+	/* Rows changed by updates are collected per parent node and reported
+	   with one dataChanged() per parent at most every tree_refresh_ms.
+	*/
+	QHash<TreeNode*, QPair<int, int>> m_dirty_rows;
+	QTimer m_refresh_timer;
+
+	/* Defined properties wait up to TREE_DEFINE_BATCH_MS, then are sorted
+	   and attached with one row insert per run of adjacent new rows. New
+	   devices and groups are filled before they are attached. Updates and
+	   deletes flush the batch first, so they always find their property.
+	*/
+	QList<indigo_property*> m_pending_defines;
+	QTimer m_define_timer;
+	PropertyIndex m_search_index;
+	QTimer m_search_timer;
+
+	template <class ChildT>
+	void insert_runs(const QModelIndex &parent, OrderedList<ChildT> &children, const QList<ChildT*> &nodes);
+
+	void mark_dirty_row(TreeNode* parent, int row);
+	void release_node(TreeNode* node);
+	QMultiHash<indigo_property*, QIndigoProperty*> m_property_widgets;
+
+	void dispatch_update(indigo_property* property);
 };
 
 #endif // PROPERTYMODEL_H
@@ -0,0 +1,108 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QDir>
+#include "qblobtrace.h"
+#include "blobtrace.h"
+
+static const char *columns[] = { "Stage", "Count", "p50 ms", "p95 ms", "p99 ms", "Max ms" };
+
+QBlobTrace::QBlobTrace(QWidget *parent): QDialog(parent)
+{
+	setWindowTitle("BLOB Latency");
+
+	m_table = new QTableWidget(BLOB_TRACE_COUNT, 6);
+	for (int column = 0; column < 6; column++)
+		m_table->setHorizontalHeaderItem(column, new QTableWidgetItem(columns[column]));
+	m_table->verticalHeader()->setVisible(false);
+	m_table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+	m_table->setSelectionMode(QAbstractItemView::NoSelection);
+	m_table->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+	m_table->setMinimumWidth(500);
+
+	m_button_box = new QDialogButtonBox;
+	m_clear_button = m_button_box->addButton(tr("Clear"), QDialogButtonBox::ActionRole);
+	m_export_button = m_button_box->addButton(tr("Export..."), QDialogButtonBox::ActionRole);
+	m_export_button->setToolTip("Save the spans as Chrome trace-event JSON");
+	m_close_button = m_button_box->addButton(tr("Close"), QDialogButtonBox::ActionRole);
+
+	QVBoxLayout* mainLayout = new QVBoxLayout;
+	mainLayout->addWidget(m_table);
+	mainLayout->addWidget(m_button_box);
+	setLayout(mainLayout);
+
+	QObject::connect(m_clear_button, SIGNAL(clicked()), this, SLOT(onClear()));
+	QObject::connect(m_export_button, SIGNAL(clicked()), this, SLOT(onExport()));
+	QObject::connect(m_close_button, SIGNAL(clicked()), this, SLOT(close()));
+	QObject::connect(&m_refresh_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+
+void QBlobTrace::showEvent(QShowEvent *event) {
+	refresh();
+	m_refresh_timer.start(BLOB_TRACE_REFRESH_MS);
+	QDialog::showEvent(event);
+}
+
+
+void QBlobTrace::hideEvent(QHideEvent *event) {
+	m_refresh_timer.stop();
+	QDialog::hideEvent(event);
+}
+
+
+void QBlobTrace::refresh() {
+	int row = 0;
+	for (const blob_trace_summary &summary : BlobTrace::instance().summary()) {
+		QString values[] = {
+			BlobTrace::stage_name(summary.stage),
+			QString::number(summary.count),
+			QString::number(summary.p50_ms, 'f', 2),
+			QString::number(summary.p95_ms, 'f', 2),
+			QString::number(summary.p99_ms, 'f', 2),
+			QString::number(summary.max_ms, 'f', 2)
+		};
+		for (int column = 0; column < 6; column++) {
+			QTableWidgetItem *item = m_table->item(row, column);
+			if (item == nullptr) {
+				item = new QTableWidgetItem;
+				if (column) item->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+				m_table->setItem(row, column, item);
+			}
+			item->setText(values[column]);
+		}
+		row++;
+	}
+}
+
+
+void QBlobTrace::onClear() {
+	BlobTrace::instance().clear();
+	refresh();
+}
+
+
+void QBlobTrace::onExport() {
+	QString path = QFileDialog::getSaveFileName(this, tr("Export BLOB trace"), QDir::homePath() + "/blob_trace.json", tr("Trace files (*.json)"));
+	if (path.isEmpty()) return;
+	BlobTrace::instance().export_chrome(path);
+}
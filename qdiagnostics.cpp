@@ -0,0 +1,144 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <QVBoxLayout>
+#include <QHeaderView>
+#include "qdiagnostics.h"
+
+QDiagnostics::QDiagnostics(QWidget *parent): QDialog(parent)
+{
+	setWindowTitle("Diagnostics");
+
+	m_tree = new QTreeWidget;
+	m_tree->setColumnCount(2);
+	m_tree->setHeaderLabels(QStringList() << "Counter" << "Value");
+	m_tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+	m_tree->setMinimumSize(420, 520);
+	m_tree->setSelectionMode(QAbstractItemView::NoSelection);
+
+	m_bus = section("Bus events / s");
+	m_devices = section("Bus events / s per device");
+	m_signals = section("Signals");
+	m_cache = section("Preview cache");
+	m_decode = section("Preview decode time");
+	m_nodes = section("Property tree nodes");
+	m_gui = section("GUI event loop");
+
+	m_button_box = new QDialogButtonBox;
+	m_close_button = m_button_box->addButton(tr("Close"), QDialogButtonBox::ActionRole);
+
+	QVBoxLayout* mainLayout = new QVBoxLayout;
+	mainLayout->addWidget(m_tree);
+	mainLayout->addWidget(m_button_box);
+	setLayout(mainLayout);
+
+	for (int i = 0; i < STAT_COUNT; i++) m_last[i] = 0;
+
+	QObject::connect(m_close_button, SIGNAL(clicked()), this, SLOT(close()));
+	QObject::connect(&m_refresh_timer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+
+QTreeWidgetItem* QDiagnostics::section(const char *title) {
+	QTreeWidgetItem *item = new QTreeWidgetItem(m_tree, QStringList() << title);
+	item->setExpanded(true);
+	item->setFirstColumnSpanned(true);
+	return item;
+}
+
+
+/* Rows are found by name so they stay put between refreshes */
+QTreeWidgetItem* QDiagnostics::row(QTreeWidgetItem *section, const QString &name) {
+	for (int i = 0; i < section->childCount(); i++) {
+		if (section->child(i)->text(0) == name) return section->child(i);
+	}
+	QTreeWidgetItem *item = new QTreeWidgetItem(section, QStringList() << name);
+	item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+	return item;
+}
+
+
+void QDiagnostics::show_counter(QTreeWidgetItem *section, stat_counter counter) {
+	row(section, Stats::name(counter))->setText(1, QString::number(Stats::instance().value(counter)));
+}
+
+
+void QDiagnostics::show_rate(QTreeWidgetItem *section, stat_counter counter, double seconds) {
+	qint64 value = Stats::instance().value(counter);
+	row(section, Stats::name(counter))->setText(1, QString::number((value - m_last[counter]) / seconds, 'f', 1));
+	m_last[counter] = value;
+}
+
+
+void QDiagnostics::showEvent(QShowEvent *event) {
+	Stats &stats = Stats::instance();
+	for (int i = 0; i < STAT_COUNT; i++) m_last[i] = stats.value((stat_counter)i);
+	m_last_devices.clear();
+	for (auto &device : stats.device_events()) m_last_devices.insert(device.first, device.second);
+	m_since_refresh.start();
+	//  The heartbeat runs only while the window is open
+	if (!m_refresh_timer.isActive()) stats.start_heartbeat();
+	m_refresh_timer.start(DIAGNOSTICS_REFRESH_MS);
+	QDialog::showEvent(event);
+}
+
+
+void QDiagnostics::hideEvent(QHideEvent *event) {
+	if (m_refresh_timer.isActive()) Stats::instance().stop_heartbeat();
+	m_refresh_timer.stop();
+	QDialog::hideEvent(event);
+}
+
+
+void QDiagnostics::refresh() {
+	Stats &stats = Stats::instance();
+	double seconds = m_since_refresh.restart() / 1000.0;
+	if (seconds <= 0) return;
+
+	show_rate(m_bus, STAT_BUS_DEFINES, seconds);
+	show_rate(m_bus, STAT_BUS_UPDATES, seconds);
+	show_rate(m_bus, STAT_BUS_DELETES, seconds);
+	show_rate(m_bus, STAT_BUS_MESSAGES, seconds);
+
+	for (auto &device : stats.device_events()) {
+		double rate = (device.second - m_last_devices.value(device.first, 0)) / seconds;
+		row(m_devices, device.first)->setText(1, QString::number(rate, 'f', 1));
+		m_last_devices.insert(device.first, device.second);
+	}
+
+	show_counter(m_signals, STAT_QUEUED_SIGNALS);
+
+	show_counter(m_cache, STAT_PREVIEW_CACHE_SIZE);
+	show_counter(m_cache, STAT_PREVIEW_CACHE_HITS);
+	show_counter(m_cache, STAT_PREVIEW_CACHE_MISSES);
+	show_counter(m_cache, STAT_PREVIEW_CACHE_EVICTIONS);
+
+	show_counter(m_decode, STAT_PREVIEW_DECODES);
+	for (int bucket = 0; bucket < STATS_DECODE_BUCKETS; bucket++)
+		row(m_decode, Stats::bucket_name(bucket))->setText(1, QString::number(stats.decode_bucket(bucket)));
+
+	show_counter(m_nodes, STAT_TREE_DEVICES);
+	show_counter(m_nodes, STAT_TREE_GROUPS);
+	show_counter(m_nodes, STAT_TREE_PROPERTIES);
+	show_counter(m_nodes, STAT_TREE_ITEMS);
+
+	show_counter(m_gui, STAT_GUI_LAG_MS);
+	show_counter(m_gui, STAT_GUI_LAG_MAX_MS);
+	show_counter(m_gui, STAT_GUI_STALLS);
+}
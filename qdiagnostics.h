@@ -0,0 +1,70 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef QDIAGNOSTICS_H
+#define QDIAGNOSTICS_H
+
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+#include "stats.h"
+
+#define DIAGNOSTICS_REFRESH_MS 1000
+
+/* Live view of the Stats counters, rates are per second since the last refresh */
+class QDiagnostics : public QDialog
+{
+	Q_OBJECT
+public:
+	QDiagnostics(QWidget *parent = 0);
+
+public slots:
+	void refresh();
+
+protected:
+	void showEvent(QShowEvent *event) override;
+	void hideEvent(QHideEvent *event) override;
+
+private:
+	QTreeWidgetItem* section(const char *title);
+	QTreeWidgetItem* row(QTreeWidgetItem *section, const QString &name);
+	void show_counter(QTreeWidgetItem *section, stat_counter counter);
+	void show_rate(QTreeWidgetItem *section, stat_counter counter, double seconds);
+
+	QTreeWidget* m_tree;
+	QTreeWidgetItem* m_bus;
+	QTreeWidgetItem* m_devices;
+	QTreeWidgetItem* m_signals;
+	QTreeWidgetItem* m_cache;
+	QTreeWidgetItem* m_decode;
+	QTreeWidgetItem* m_nodes;
+	QTreeWidgetItem* m_gui;
+	QDialogButtonBox* m_button_box;
+	QPushButton* m_close_button;
+	QTimer m_refresh_timer;
+	QElapsedTimer m_since_refresh;
+	qint64 m_last[STAT_COUNT];
+	QHash<QString, qint64> m_last_devices;
+};
+
+#endif // QDIAGNOSTICS_H
@@ -0,0 +1,217 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <math.h>
+#include <QPainter>
+#include <QPixmapCache>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include "qimageview.h"
+#include "conf.h"
+
+
+QImageView::QImageView(QWidget *parent) :
+	QWidget(parent),
+	m_fit(true),
+	m_zoom(1.0),
+	m_offset(0, 0),
+	m_dragging(false) {
+	setFixedSize(PREVIEW_WIDTH, PREVIEW_WIDTH * 2 / 3);
+	if (QPixmapCache::cacheLimit() < PREVIEW_PIXMAP_CACHE_KB)
+		QPixmapCache::setCacheLimit(PREVIEW_PIXMAP_CACHE_KB);
+}
+
+
+void QImageView::set_image(const preview_image &image) {
+	if (!m_image.isNull() && image.generation() == m_image.generation()) return;
+
+	bool same_size = (image.size() == m_image.size());
+	m_image = image;
+	if (!same_size) {
+		m_fit = true;
+		m_offset = QPointF(0, 0);
+		if (!m_image.isNull() && m_image.width() > 0)
+			setFixedSize(PREVIEW_WIDTH, qMax(1, PREVIEW_WIDTH * m_image.height() / m_image.width()));
+	}
+	update();
+}
+
+
+/* Short status line drawn over the image, like the live preview rate */
+void QImageView::set_overlay(const QString &text) {
+	if (text == m_overlay) return;
+	m_overlay = text;
+	update();
+}
+
+
+void QImageView::zoom_fit() {
+	m_fit = true;
+	m_offset = QPointF(0, 0);
+	setCursor(Qt::ArrowCursor);
+	update();
+}
+
+
+void QImageView::zoom_actual(const QPointF &center) {
+	set_zoom(1.0, center);
+}
+
+
+double QImageView::fit_zoom() const {
+	if (m_image.isNull()) return 1.0;
+	return qMin((double)width() / m_image.width(), (double)height() / m_image.height());
+}
+
+
+/* anchor is in widget coordinates, the image point under it stays put */
+void QImageView::set_zoom(double zoom, const QPointF &anchor) {
+	if (m_image.isNull()) return;
+
+	double old_zoom = this->zoom();
+	double min_zoom = fit_zoom();
+	zoom = qBound(min_zoom, zoom, PREVIEW_MAX_ZOOM);
+	if (zoom <= min_zoom) {
+		zoom_fit();
+		return;
+	}
+	QPointF point = m_offset + anchor / old_zoom;
+	m_fit = false;
+	m_zoom = zoom;
+	m_offset = point - anchor / zoom;
+	clamp_offset();
+	setCursor(Qt::OpenHandCursor);
+	update();
+}
+
+
+/* offset is the image point shown at the top left corner */
+void QImageView::clamp_offset() {
+	double zoom = this->zoom();
+	double spare_x = m_image.width() - width() / zoom;
+	double spare_y = m_image.height() - height() / zoom;
+	m_offset.setX(spare_x > 0 ? qBound(0.0, m_offset.x(), spare_x) : spare_x / 2);
+	m_offset.setY(spare_y > 0 ? qBound(0.0, m_offset.y(), spare_y) : spare_y / 2);
+}
+
+
+/* Tiles of an older generation are never asked for again and age out of the cache */
+QPixmap QImageView::tile(int level, int tx, int ty) {
+	QString key = QString("preview:%1:%2:%3:%4").arg(m_image.generation()).arg(level).arg(tx).arg(ty);
+	QPixmap pixmap;
+	if (!QPixmapCache::find(key, &pixmap)) {
+		const QImage &source = m_image.level(level);
+		QRect rect(tx * PREVIEW_TILE_SIZE, ty * PREVIEW_TILE_SIZE, PREVIEW_TILE_SIZE, PREVIEW_TILE_SIZE);
+		pixmap = QPixmap::fromImage(source.copy(rect.intersected(source.rect())));
+		QPixmapCache::insert(key, pixmap);
+	}
+	return pixmap;
+}
+
+
+void QImageView::paintEvent(QPaintEvent *) {
+	QPainter painter(this);
+	painter.fillRect(rect(), Qt::black);
+	if (m_image.isNull()) return;
+
+	if (m_fit) m_offset = QPointF(0, 0);
+	clamp_offset();
+	double zoom = this->zoom();
+
+	// the smallest level that still has at least one pixel per screen pixel
+	int level = 0;
+	while (level + 1 < m_image.level_count() && zoom * (1 << (level + 1)) <= 1.0) level++;
+
+	const QImage &source = m_image.level(level);
+	double factor = (double)m_image.width() / source.width();
+	double scale = zoom * factor;
+	QRectF visible(m_offset.x() / factor, m_offset.y() / factor, width() / scale, height() / scale);
+
+	int tx_first = qMax(0, (int)floor(visible.left() / PREVIEW_TILE_SIZE));
+	int ty_first = qMax(0, (int)floor(visible.top() / PREVIEW_TILE_SIZE));
+	int tx_last = qMin((source.width() - 1) / PREVIEW_TILE_SIZE, (int)floor(visible.right() / PREVIEW_TILE_SIZE));
+	int ty_last = qMin((source.height() - 1) / PREVIEW_TILE_SIZE, (int)floor(visible.bottom() / PREVIEW_TILE_SIZE));
+
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, scale < 1.0);
+	for (int ty = ty_first; ty <= ty_last; ty++) {
+		for (int tx = tx_first; tx <= tx_last; tx++) {
+			QPixmap pixmap = tile(level, tx, ty);
+			QRectF target(
+				(tx * PREVIEW_TILE_SIZE - visible.left()) * scale,
+				(ty * PREVIEW_TILE_SIZE - visible.top()) * scale,
+				pixmap.width() * scale,
+				pixmap.height() * scale
+			);
+			painter.drawPixmap(target, pixmap, QRectF(pixmap.rect()));
+		}
+	}
+
+	if (!m_overlay.isEmpty()) {
+		painter.setPen(QColor(241, 183, 1));
+		painter.drawText(rect().adjusted(6, 4, -6, -4), Qt::AlignTop | Qt::AlignLeft, m_overlay);
+	}
+}
+
+
+void QImageView::resizeEvent(QResizeEvent *event) {
+	QWidget::resizeEvent(event);
+	clamp_offset();
+}
+
+
+/* Plain wheel scrolls the panel the view sits in, Ctrl+wheel zooms */
+void QImageView::wheelEvent(QWheelEvent *event) {
+	double steps = event->angleDelta().y() / 120.0;
+	if (steps == 0 || !(event->modifiers() & Qt::ControlModifier)) {
+		event->ignore();
+		return;
+	}
+	set_zoom(zoom() * pow(1.25, steps), event->posF());
+	event->accept();
+}
+
+
+void QImageView::mousePressEvent(QMouseEvent *event) {
+	if (event->button() != Qt::LeftButton || m_fit) return;
+	m_dragging = true;
+	m_drag_start = event->pos();
+	m_drag_offset = m_offset;
+	setCursor(Qt::ClosedHandCursor);
+}
+
+
+void QImageView::mouseMoveEvent(QMouseEvent *event) {
+	if (!m_dragging) return;
+	m_offset = m_drag_offset - QPointF(event->pos() - m_drag_start) / zoom();
+	clamp_offset();
+	update();
+}
+
+
+void QImageView::mouseReleaseEvent(QMouseEvent *event) {
+	if (event->button() != Qt::LeftButton || !m_dragging) return;
+	m_dragging = false;
+	setCursor(Qt::OpenHandCursor);
+}
+
+
+void QImageView::mouseDoubleClickEvent(QMouseEvent *event) {
+	if (m_fit) zoom_actual(event->pos());
+	else zoom_fit();
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef QIMAGEVIEW_H
+#define QIMAGEVIEW_H
+
+#include <QWidget>
+#include <QPixmap>
+#include <QPointF>
+#include "blobpreview.h"
+
+/* Tile pixmaps live in QPixmapCache keyed by preview generation, level and
+   position, so every view of the same frame and every rebuilt form reuses
+   them. 64 MB holds about 256 tiles.
+*/
+#define PREVIEW_PIXMAP_CACHE_KB (64 * 1024)
+#define PREVIEW_MAX_ZOOM 8.0
+
+
+/* Zoomable and pannable preview. Only the tiles that are visible are turned
+   into pixmaps, taken from the mip level closest to the current zoom.
+   Ctrl+wheel zooms around the cursor, drag pans and double click toggles
+   between fit and 1:1.
+*/
+class QImageView : public QWidget {
+	Q_OBJECT
+public:
+	explicit QImageView(QWidget *parent = nullptr);
+
+	void set_image(const preview_image &image);
+	void set_overlay(const QString &text);
+
+public slots:
+	void zoom_fit();
+	void zoom_actual(const QPointF &center);
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void wheelEvent(QWheelEvent *event) override;
+	void mousePressEvent(QMouseEvent *event) override;
+	void mouseMoveEvent(QMouseEvent *event) override;
+	void mouseReleaseEvent(QMouseEvent *event) override;
+	void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+	double fit_zoom() const;
+	double zoom() const { return m_fit ? fit_zoom() : m_zoom; }
+	void set_zoom(double zoom, const QPointF &anchor);
+	void clamp_offset();
+	QPixmap tile(int level, int tx, int ty);
+
+	preview_image m_image;
+	QString m_overlay;
+	bool m_fit;
+	double m_zoom;
+	QPointF m_offset;
+	bool m_dragging;
+	QPoint m_drag_start;
+	QPointF m_drag_offset;
+};
+
+#endif // QIMAGEVIEW_H
@@ -19,6 +19,7 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <string.h>
 #include <QUrl>
 #include <QDir>
 #include <QDesktopServices>
@@ -26,8 +27,28 @@
 #include <QHBoxLayout>
 #include <QPixmap>
 #include "qindigoblob.h"
+#include "qimageview.h"
+#include "livepreview.h"
+#include "indigoclient.h"
 #include "conf.h"
 #include "blobpreview.h"
+#include "blobnaming.h"
+#include "blobrecorder.h"
+#include "blobtrace.h"
+
+
+/* Live frames go only to the widgets showing their stream, like property
+   updates in PropertyModel::dispatch_update()
+*/
+static QMultiHash<QString, QIndigoBLOB*> live_widgets;
+
+static void dispatch_live_frame(const QString &key) {
+	auto i = live_widgets.constFind(key);
+	while (i != live_widgets.constEnd() && i.key() == key) {
+		i.value()->live_frame();
+		++i;
+	}
+}
 
 
 QIndigoBLOB::QIndigoBLOB(QIndigoProperty* p, indigo_property* property, indigo_item* item, QWidget *parent)
@@ -37,7 +58,7 @@ QIndigoBLOB::QIndigoBLOB(QIndigoProperty* p, indigo_property* property, indigo_i
 	label = new QLabel(m_item->label);
 	label->setObjectName("INDIGO_property");
 
-	image = new QLabel();
+	image = new QImageView();
 	image->setObjectName("INDIGO_property");
 
 	text = new QLineEdit();
@@ -71,29 +92,53 @@ QIndigoBLOB::QIndigoBLOB(QIndigoProperty* p, indigo_property* property, indigo_i
 	vbox->addWidget(base);
 
 	connect(text, &QLineEdit::textEdited, this, &QIndigoBLOB::dirty);
+
+	m_preview_key = preview_key(m_property->device, m_property->name, m_item->name);
+	static bool dispatch_connected = false;
+	if (!dispatch_connected) {
+		connect(&LivePreview::instance(), &LivePreview::frame_ready, &LivePreview::instance(), dispatch_live_frame);
+		dispatch_connected = true;
+	}
+	live_widgets.insert(m_preview_key, this);
 }
 
 
 QIndigoBLOB::~QIndigoBLOB() {
+	live_widgets.remove(m_preview_key, this);
 	//delete label;
 	//delete text;
 }
 
 
+/* One placeholder for all BLOB items, it keeps its generation and its tiles */
+static const preview_image& no_preview() {
+	static preview_image placeholder(QImage(":resource/no-preview.png"));
+	return placeholder;
+}
+
+
 void QIndigoBLOB::update() {
 	//  Apply update from indigo bus only if not being edited
 	if (*m_item->blob.url) {
 		text->setText(m_item->blob.url);
 	}
 
-	QImage *preview = preview_cache.get(m_property, m_item);
-	if (preview == nullptr) {
-		QPixmap pixmap(":resource/no-preview.png");
-		image->setPixmap(pixmap.scaledToWidth(PREVIEW_WIDTH, Qt::SmoothTransformation));
+	BlobTrace &trace = BlobTrace::instance();
+	qint64 begin_us = trace.enabled() ? trace.now_us() : 0;
+	preview_image preview;
+	if (!preview_cache.copy(m_property, m_item, &preview)) {
+		image->set_image(no_preview());
 		return;
 	}
-	QPixmap pixmap = QPixmap::fromImage(*preview);
-	image->setPixmap(pixmap.scaledToWidth(PREVIEW_WIDTH, Qt::SmoothTransformation));
+	// Nothing is uploaded or scaled unless the frame generation changed
+	image->set_image(preview);
+	image->set_overlay(IndigoClient::instance().live_preview() ? LivePreview::instance().overlay(m_preview_key) : QString());
+	if (trace.enabled()) trace.painted(m_preview_key, begin_us);
+}
+
+
+void QIndigoBLOB::live_frame() {
+	update();
 }
 
 
@@ -132,8 +177,6 @@ void close_fd(int fd) {
 
 void QIndigoBLOB::save_blob_item() {
 	if ((m_property->state == INDIGO_OK_STATE) && (m_item->blob.value != NULL)) {
-		char file_name[PATH_LEN];
-		char message[PATH_LEN+100];
 		char location[PATH_LEN];
 
 		if (QStandardPaths::displayName(QStandardPaths::PicturesLocation).length() > 0) {
@@ -145,12 +188,11 @@ void QIndigoBLOB::save_blob_item() {
 			}
 		}
 
-		if (save_blob_item_with_prefix(location, file_name)) {
-			snprintf(message, sizeof(message), "Image saved to '%s'", file_name);
-			m_logger->log(NULL, message);
-		} else {
-			snprintf(message, sizeof(message), "Can not save '%s'", file_name);
-			m_logger->log(NULL, message);
+		// Written by the BLOB writer thread, the result is reported to the log
+		if (!BlobRecorder::instance().running()) {
+			m_logger->log(NULL, "Can not save image, the BLOB writer is not running");
+		} else if (!BlobRecorder::instance().save(location, m_property, m_item)) {
+			m_logger->log(NULL, "Can not save image, too many saves pending");
 		}
 	}
 }
@@ -181,20 +223,22 @@ void QIndigoBLOB::view_blob_item() {
 
 bool QIndigoBLOB::save_blob_item_with_prefix(const char *prefix, char *file_name) {
 	int fd;
-	int file_no = 0;
 
+	/* Names come from the per-directory counter, a clash is only possible with
+	   files created behind our back and then the next number is taken
+	*/
+	int tries = 0;
 	do {
-
+		BlobFileNamer::instance().make_name(prefix, m_property->device, m_property->name, m_item->name, m_item->blob.format, file_name, PATH_LEN);
 #if defined(INDIGO_WINDOWS)
-		sprintf(file_name, "%s\\blob_%03d%s", prefix, file_no++, m_item->blob.format);
 		fd = open(file_name, O_CREAT | O_WRONLY | O_EXCL | O_BINARY, 0);
 #else
-		sprintf(file_name, "%s/blob_%03d%s", prefix, file_no++, m_item->blob.format);
 		fd = open(file_name, O_CREAT | O_WRONLY | O_EXCL, S_IRUSR | S_IWUSR);
 #endif
-	} while ((fd < 0) && (errno == EEXIST));
+	} while ((fd < 0) && (errno == EEXIST) && (++tries < BLOB_NAME_MAX_TRIES));
 
 	if (fd < 0) {
+		indigo_error("Can not create '%s': %s\n", file_name, strerror(errno));
 		return false;
 	} else {
 		write(fd, m_item->blob.value, m_item->blob.size);
@@ -23,9 +23,12 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QWidget>
+#include <QMultiHash>
 #include "qindigoswitch.h"
 #include "logger.h"
 
+class QImageView;
+
 class QIndigoBLOB : public QWidget, public QIndigoItem {
 	Q_OBJECT
 public:
@@ -38,13 +41,15 @@ public slots:
 	void dirty();
 	void save_blob_item();
 	void view_blob_item();
+	void live_frame();
 
 private:
 	Logger* m_logger;
 	QLabel* label;
-	QLabel* image;
+	QImageView* image;
 	QLineEdit* text;
 	bool m_dirty;
+	QString m_preview_key;
 
 	virtual void update();
 	virtual void reset();
@@ -19,6 +19,7 @@
 
 #include <QHBoxLayout>
 #include "qindigolight.h"
+#include "iconcache.h"
 
 
 QIndigoLight::QIndigoLight(QIndigoProperty* p, indigo_property* property, indigo_item* item, QWidget *parent)
@@ -48,18 +49,5 @@ QIndigoLight::~QIndigoLight() {
 
 void
 QIndigoLight::update() {
-	switch (m_item->light.value) {
-	case INDIGO_IDLE_STATE:
-		led->setPixmap(QPixmap(":resource/led-grey.png"));
-		break;
-	case INDIGO_BUSY_STATE:
-		led->setPixmap(QPixmap(":resource/led-orange.png"));
-		break;
-	case INDIGO_ALERT_STATE:
-		led->setPixmap(QPixmap(":resource/led-red.png"));
-		break;
-	case INDIGO_OK_STATE:
-		led->setPixmap(QPixmap(":resource/led-green.png"));
-		break;
-	}
+	led->setPixmap(IconCache::instance().state_led(m_item->light.value, false));
 }
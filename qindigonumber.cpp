@@ -18,8 +18,13 @@
 
 
 #include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPushButton>
 #include <indigo/indigo_bus.h>
 #include "qindigonumber.h"
+#include "qindigosparkline.h"
 
 
 QIndigoNumber::QIndigoNumber(QIndigoProperty* p, indigo_property* property, indigo_item* item, QWidget *parent)
@@ -35,6 +40,7 @@ QIndigoNumber::QIndigoNumber(QIndigoProperty* p, indigo_property* property, indi
 	text_value->setReadOnly(true);
 	text_target = nullptr;
 	m_dirty = false;
+	sparkline = new QIndigoSparkline(m_property, m_item - m_property->items, SPARKLINE_SPAN_S, false);
 	if (m_property->perm != INDIGO_RO_PERM) {
 		text_target = new QLineEdit();
 		if (m_item->number.format[strlen(m_item->number.format) - 1] == 'm') {
@@ -84,6 +90,9 @@ QIndigoNumber::QIndigoNumber(QIndigoProperty* p, indigo_property* property, indi
 		hbox->addWidget(text_target, 16);
 		connect(text_target, &QLineEdit::textEdited, this, &QIndigoNumber::dirty);
 	}
+	hbox->addSpacing(5);
+	hbox->addWidget(sparkline);
+	connect(sparkline, &QIndigoSparkline::clicked, this, &QIndigoNumber::show_plot);
 }
 
 QIndigoNumber::~QIndigoNumber() {
@@ -100,6 +109,8 @@ void QIndigoNumber::update() {
 		snprintf(buffer, sizeof(buffer), m_item->number.format, m_item->number.value);
 	}
 	text_value->setText(buffer);
+	sparkline->update();
+	if (m_plot) m_plot->update();
 	if (text_target && !m_dirty && !text_target->hasFocus()) {
 		if (m_item->number.format[strlen(m_item->number.format) - 1] == 'm')
 			strncpy(buffer, indigo_dtos(m_item->number.target, NULL), sizeof(buffer));
@@ -134,3 +145,27 @@ void QIndigoNumber::dirty() {
 		text_target->setStyleSheet("color: #CCCC00");
 	}
 }
+
+void QIndigoNumber::show_plot() {
+	if (m_plot) {
+		m_plot->window()->raise();
+		return;
+	}
+	QDialog* dialog = new QDialog(this);
+	dialog->setAttribute(Qt::WA_DeleteOnClose);
+	dialog->setWindowTitle(QString("%1 . %2 . %3").arg(m_property->device, m_property->label, m_item->label));
+
+	m_plot = new QIndigoSparkline(m_property, m_item - m_property->items, 0, true);
+	m_plot->setMinimumSize(600, 300);
+
+	QDialogButtonBox* button_box = new QDialogButtonBox;
+	QPushButton* close_button = button_box->addButton(tr("Close"), QDialogButtonBox::ActionRole);
+
+	QVBoxLayout* layout = new QVBoxLayout;
+	layout->addWidget(m_plot);
+	layout->addWidget(button_box);
+	dialog->setLayout(layout);
+
+	QObject::connect(close_button, SIGNAL(clicked()), dialog, SLOT(close()));
+	dialog->show();
+}
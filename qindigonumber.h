@@ -23,10 +23,12 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QWidget>
+#include <QPointer>
 #include "qindigoswitch.h"
 
 
 class QIndigoProperty;
+class QIndigoSparkline;
 
 
 class QIndigoNumber : public QWidget, public QIndigoItem {
@@ -44,11 +46,14 @@ signals:
 
 public slots:
 	void dirty();
+	void show_plot();
 
 private:
 	QLabel* label;
 	QLineEdit* text_value;
 	QLineEdit* text_target;
+	QIndigoSparkline* sparkline;
+	QPointer<QIndigoSparkline> m_plot;
 	bool m_dirty;
 };
 
@@ -22,6 +22,7 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QPushButton>
+#include <QStyle>
 #include <QVBoxLayout>
 #include "qindigoproperty.h"
 #include "qindigotext.h"
@@ -29,10 +30,11 @@
 #include "qindigoswitch.h"
 #include "qindigolight.h"
 #include "qindigoblob.h"
+#include "iconcache.h"
 #include "conf.h"
 
 
-QIndigoProperty::QIndigoProperty(indigo_property* property, QWidget *parent) : QWidget(parent), m_property(property) {
+QIndigoProperty::QIndigoProperty(indigo_property* property, QWidget *parent) : QWidget(parent), m_property(property), m_shown_state(-1) {
 	//  Set widget layout
 	QVBoxLayout* formLayout = new QVBoxLayout;
 	formLayout->setAlignment(Qt::AlignTop);
@@ -46,6 +48,10 @@ QIndigoProperty::QIndigoProperty(indigo_property* property, QWidget *parent) : Q
 
 	//  Add the control grid
 	build_property_form(formLayout);
+
+	//  State colours come from the "state" rules in control_panel.qss
+	m_styled_widgets = findChildren<QWidget*>("INDIGO_property");
+	update_property_view();
 }
 
 
@@ -62,54 +68,42 @@ void QIndigoProperty::update_controls() {
 
 
 void QIndigoProperty::update_property_view() {
+	const char *state = nullptr;
+
+	//  Re-polishing is needed only when the state really changes
+	if (m_shown_state == m_property->state) return;
+	m_shown_state = m_property->state;
+
 	switch (m_property->state) {
 	case INDIGO_IDLE_STATE:
-		m_led->setPixmap(QPixmap(":resource/led-grey.png"));
-		this->setStyleSheet(
-			"#INDIGO_property { background-color: #272727; border: 0px}"
-			"QLineEdit#INDIGO_property { background-color: #222222}"
-			"QPushButton#INDIGO_property { background-color: #323232 }"
-			"QPushButton#INDIGO_property:focus { background-color: #393939 }"
-		);
+		state = "idle";
 		break;
 	case INDIGO_BUSY_STATE:
-		if (conf.use_state_icons)
-			m_led->setPixmap(QPixmap(":resource/led-orange-cb.png"));
-		else
-			m_led->setPixmap(QPixmap(":resource/led-orange.png"));
-		this->setStyleSheet(
-			"#INDIGO_property { background-color: #353520; border: 0px}"
-			"QLineEdit#INDIGO_property { background-color: #252520}"
-			"QPushButton#INDIGO_property { background-color: #454522 }"
-			"QPushButton#INDIGO_property:focus { background-color: #505022 }"
-		);
+		state = "busy";
 		break;
 	case INDIGO_ALERT_STATE:
-		if (conf.use_state_icons)
-			m_led->setPixmap(QPixmap(":resource/led-red-cb.png"));
-		else
-			m_led->setPixmap(QPixmap(":resource/led-red.png"));
-		this->setStyleSheet(
-			"#INDIGO_property { background-color: #352222; border: 0px}"
-			"QLineEdit#INDIGO_property { background-color: #252222}"
-			"QPushButton#INDIGO_property { background-color: #452222 }"
-			"QPushButton#INDIGO_property:focus { background-color: #502222 }"
-		);
+		state = "alert";
 		break;
 	case INDIGO_OK_STATE:
-		if (conf.use_state_icons)
-			m_led->setPixmap(QPixmap(":resource/led-green-cb.png"));
-		else
-			m_led->setPixmap(QPixmap(":resource/led-green.png"));
-		this->setStyleSheet(
-			"#INDIGO_property { background-color: #203220; border: 0px}"
-			"QLineEdit#INDIGO_property { background-color: #202520}"
-			"QPushButton#INDIGO_property { background-color: #224322 }"
-			"QPushButton#INDIGO_property:focus { background-color: #225022 }"
-		);
+		state = "ok";
 		break;
 	}
+	m_led->setPixmap(IconCache::instance().state_led(m_property->state, conf.use_state_icons));
 	m_led->update();
+
+	if (state == nullptr) return;
+	for (auto i = m_styled_widgets.constBegin(); i != m_styled_widgets.constEnd(); ++i) {
+		QWidget *widget = *i;
+		widget->setProperty("state", state);
+		widget->style()->unpolish(widget);
+		widget->style()->polish(widget);
+	}
+}
+
+
+void QIndigoProperty::restyle() {
+	m_shown_state = -1;
+	update_property_view();
 }
 
 
@@ -197,8 +191,6 @@ void QIndigoProperty::build_property_form(QVBoxLayout* layout) {
 	QVBoxLayout* property_layout = new QVBoxLayout();
 	property_setings->setLayout(property_layout);
 
-	update_property_view();
-
 	//  Build the item fields
 	switch (m_property->type) {
 	case INDIGO_TEXT_VECTOR:
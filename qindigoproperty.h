@@ -36,6 +36,9 @@ public:
 	virtual ~QIndigoProperty();
 
 	void update_controls();
+	indigo_property* get_property() const { return m_property; }
+	/* Shows the state again, after the state style has changed */
+	void restyle();
 
 private:
 	void build_property_form(QVBoxLayout* layout);
@@ -59,6 +62,8 @@ private:
 	indigo_property* m_property;
 	QLabel* m_led;
 	QIndigoItem** m_controls;
+	QList<QWidget*> m_styled_widgets;
+	int m_shown_state;
 };
 
 #endif // QINDIGOPROPERTY_H
@@ -79,18 +79,50 @@ QIndigoServers::QIndigoServers(QWidget *parent): QDialog(parent)
 void QIndigoServers::onConnectionChange(QIndigoService &indigo_service) {
 	QString service_name = indigo_service.name();
 	indigo_debug("Connection State Change [%s] connected = %d\n", service_name.toUtf8().constData(), indigo_service.connected());
-	QListWidgetItem* item = 0;
-	for(int i = 0; i < m_server_list->count(); ++i){
-		item = m_server_list->item(i);
-		QString service = getServiceName(item);
-		if (service == service_name) {
-			if (indigo_service.connected())
-				item->setCheckState(Qt::Checked);
-			else
-				item->setCheckState(Qt::Unchecked);
-			break;
-		}
+	QListWidgetItem* item = findItem(service_name);
+	if (item == nullptr) return;
+	showStatus(item, indigo_service.connected() ? tr("Connected") : tr("Not connected"), false);
+	if (indigo_service.connected())
+		item->setCheckState(Qt::Checked);
+	else
+		item->setCheckState(Qt::Unchecked);
+}
+
+
+void QIndigoServers::onConnecting(QIndigoService &indigo_service) {
+	QListWidgetItem* item = findItem(indigo_service.name());
+	if (item == nullptr) return;
+	showStatus(item, tr("Connecting..."), true);
+}
+
+
+void QIndigoServers::onConnectFailed(QIndigoService &indigo_service) {
+	QListWidgetItem* item = findItem(indigo_service.name());
+	if (item == nullptr) return;
+	showStatus(item, tr("Connection failed"), false);
+	item->setCheckState(Qt::Unchecked);
+}
+
+
+QListWidgetItem* QIndigoServers::findItem(const QString &service_name) {
+	for (int i = 0; i < m_server_list->count(); ++i) {
+		QListWidgetItem* item = m_server_list->item(i);
+		if (getServiceName(item) == service_name) return item;
 	}
+	return nullptr;
+}
+
+
+/* Pending connections are shown in italics. Any change of an item emits
+   itemChanged(), which would be taken for a click on its check box.
+*/
+void QIndigoServers::showStatus(QListWidgetItem* item, const QString &status, bool pending) {
+	bool blocked = m_server_list->blockSignals(true);
+	QFont font = item->font();
+	font.setItalic(pending);
+	item->setFont(font);
+	item->setToolTip(status);
+	m_server_list->blockSignals(blocked);
 }
 
 
@@ -52,10 +52,15 @@ public slots:
 	void onRemoveService(QIndigoService &indigo_service);
 	void highlightChecked(QListWidgetItem* item);
 	void onConnectionChange(QIndigoService &indigo_service);
+	void onConnecting(QIndigoService &indigo_service);
+	void onConnectFailed(QIndigoService &indigo_service);
 	void onAddManualService();
 	void onRemoveManualService();
 
 private:
+	QListWidgetItem* findItem(const QString &service_name);
+	void showStatus(QListWidgetItem* item, const QString &status, bool pending);
+
 	QListWidget* m_server_list;
 	QDialogButtonBox* m_button_box;
 	QWidget* m_view_box;
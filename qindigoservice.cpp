@@ -25,12 +25,13 @@ QIndigoService::QIndigoService(const QZeroConfService& _service) :
 	m_port(_service.port()),
 	m_service(_service),
 	m_server_entry(nullptr),
+	m_connection_state(SERVICE_DISCONNECTED),
 	isQZeroConfService(true),
 	prevSocket(0) {
 }
 
 
-QIndigoService::QIndigoService(const QIndigoService &other) : m_service(other.m_service) {
+QIndigoService::QIndigoService(const QIndigoService &other) : m_service(other.m_service), m_server_entry(nullptr), m_connection_state(SERVICE_DISCONNECTED) {
 }
 
 
@@ -39,6 +40,7 @@ QIndigoService::QIndigoService(QByteArray name, QByteArray host, int port) :
 	m_host(host),
 	m_port(port),
 	m_server_entry(nullptr),
+	m_connection_state(SERVICE_DISCONNECTED),
 	isQZeroConfService(false),
 	prevSocket(0) {
 }
@@ -49,15 +51,32 @@ QIndigoService::~QIndigoService() {
 
 
 bool QIndigoService::connect() {
-	int i = 5; /* 0.5 seconds */
 	prevSocket = -100;
 	indigo_debug("%s(): %s %s %d\n",__FUNCTION__, m_name.constData(), m_host.constData(), m_port);
 	indigo_result res = indigo_connect_server(m_name.constData(), m_host.constData(), m_port, &m_server_entry);
-	if (res != INDIGO_OK) return false;
-	while (!connected() && i--) {
-		indigo_usleep(100000);
+	if (res != INDIGO_OK) {
+		m_connection_state = SERVICE_CONNECT_FAILED;
+		return false;
 	}
-	return connected();
+	/* indigo_connect_server() connects in its own thread, do not wait for it here */
+	m_connection_state = SERVICE_CONNECTING;
+	m_connect_timer.start();
+	return true;
+}
+
+
+service_connection_state QIndigoService::update_connection_state(int timeout_ms) {
+	if (m_connection_state != SERVICE_CONNECTING) return m_connection_state;
+
+	if (connected()) {
+		m_connection_state = SERVICE_CONNECTED;
+	} else if (m_connect_timer.hasExpired(timeout_ms)) {
+		indigo_debug("%s(): %s %s %d timed out\n",__FUNCTION__, m_name.constData(), m_host.constData(), m_port);
+		//  Stop the server thread, it would keep retrying behind the failed state
+		disconnect();
+		m_connection_state = SERVICE_CONNECT_FAILED;
+	}
+	return m_connection_state;
 }
 
 
@@ -75,6 +94,7 @@ bool QIndigoService::disconnect() {
 		indigo_debug("%s(): %s %s %d\n",__FUNCTION__, m_name.constData(), m_host.constData(), m_port);
 		bool res = (indigo_disconnect_server(m_server_entry) == INDIGO_OK);
 		m_server_entry=nullptr;
+		m_connection_state = SERVICE_DISCONNECTED;
 		return res;
 	}
 	return false;
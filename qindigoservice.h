@@ -21,9 +21,17 @@
 #define INDIGOSERVICE_H
 
 #include <QObject>
+#include <QElapsedTimer>
 #include <qzeroconf.h>
 #include <indigo/indigo_client.h>
 
+typedef enum {
+	SERVICE_DISCONNECTED = 0,
+	SERVICE_CONNECTING,
+	SERVICE_CONNECTED,
+	SERVICE_CONNECT_FAILED
+} service_connection_state;
+
 
 class QIndigoService {
 
@@ -42,6 +50,13 @@ public:
 	bool connect();
 	bool connected() const;
 	bool disconnect();
+
+	/* connect() only starts the connection, the owner calls
+	   update_connection_state() until it is no longer SERVICE_CONNECTING
+	*/
+	service_connection_state update_connection_state(int timeout_ms);
+	service_connection_state connection_state() const { return m_connection_state; }
+
 	QByteArray name() const { return m_name; }
 	QByteArray host() const { return m_host; }
 	int port() const { return m_port; }
@@ -51,6 +66,8 @@ public:
 	int m_port;
 	QZeroConfService m_service;
 	indigo_server_entry* m_server_entry;
+	service_connection_state m_connection_state;
+	QElapsedTimer m_connect_timer;
 
 public:
 	bool isQZeroConfService;
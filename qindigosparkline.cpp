@@ -0,0 +1,97 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <math.h>
+#include <QPainter>
+#include <QMouseEvent>
+#include "qindigosparkline.h"
+#include "history.h"
+
+QIndigoSparkline::QIndigoSparkline(indigo_property *property, int item, double span, bool labels, QWidget *parent)
+	: QWidget(parent), m_property(property), m_item(item), m_span(span), m_labels(labels) {
+	if (!labels) {
+		setFixedWidth(SPARKLINE_WIDTH);
+		setToolTip("Trend of the last 10 minutes, click for the whole history");
+	}
+	setMinimumHeight(16);
+}
+
+
+void QIndigoSparkline::resizeEvent(QResizeEvent *) {
+	//  Column buffers follow the width, painting does not allocate
+	m_min.resize(width());
+	m_max.resize(width());
+}
+
+
+void QIndigoSparkline::mouseReleaseEvent(QMouseEvent *event) {
+	if (event->button() == Qt::LeftButton && rect().contains(event->pos())) emit(clicked());
+}
+
+
+void QIndigoSparkline::paintEvent(QPaintEvent *) {
+	//  The history is looked up every time, it goes away with the property
+	const ItemHistory *history = History::instance().find(m_property, m_item);
+	if (history == nullptr || history->count() == 0) return;
+
+	int columns = m_min.size();
+	if (columns == 0) return;
+	double to = history->time(history->count() - 1);
+	double from = (m_span > 0) ? to - m_span : history->time(0);
+	if (to - from < 1.0) from = to - 1.0;
+	int seconds = (int)(to - from);
+	//  The newest sample falls into the last column
+	to += (to - from) / columns;
+	history->decimate(from, to, columns, m_min.data(), m_max.data());
+
+	double lo = NAN, hi = NAN;
+	for (int c = 0; c < columns; c++) {
+		if (isnan(m_min[c])) continue;
+		if (isnan(lo) || m_min[c] < lo) lo = m_min[c];
+		if (isnan(hi) || m_max[c] > hi) hi = m_max[c];
+	}
+	if (isnan(lo)) return;
+
+	QPainter painter(this);
+	QRect area = rect().adjusted(1, 2, -1, -2);
+	if (m_labels) area.adjust(0, 16, 0, -16);
+	double range = (hi > lo) ? hi - lo : 1.0;
+	double scale = area.height() / range;
+	auto y = [&](double v) { return area.bottom() - (int)((v - lo) * scale); };
+
+	painter.setPen(QColor(241, 183, 1));
+	int previous = -1;
+	for (int c = 0; c < columns; c++) {
+		if (isnan(m_min[c])) continue;
+		double bottom = m_min[c], top = m_max[c];
+		//  Join with the previous column so the line is continuous
+		if (previous >= 0) {
+			bottom = qMin(bottom, m_max[previous]);
+			top = qMax(top, m_min[previous]);
+		}
+		painter.drawLine(c, y(bottom), c, y(top));
+		previous = c;
+	}
+
+	if (m_labels) {
+		painter.setPen(Qt::white);
+		painter.drawText(rect().adjusted(4, 0, -4, 0), Qt::AlignTop | Qt::AlignLeft, QString("max %1").arg(hi, 0, 'g', 8));
+		painter.drawText(rect().adjusted(4, 0, -4, 0), Qt::AlignBottom | Qt::AlignLeft, QString("min %1").arg(lo, 0, 'g', 8));
+		painter.drawText(rect().adjusted(4, 0, -4, 0), Qt::AlignBottom | Qt::AlignRight, QString("last %1 s").arg(seconds));
+	}
+}
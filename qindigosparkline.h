@@ -0,0 +1,56 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QINDIGOSPARKLINE_H
+#define QINDIGOSPARKLINE_H
+
+#include <QWidget>
+#include <QVector>
+#include <indigo/indigo_bus.h>
+
+#define SPARKLINE_WIDTH 60
+#define SPARKLINE_SPAN_S 600.0
+
+/* Trend of one number item taken from its History. Samples are decimated to
+   the min and max of each pixel column, so painting costs one pass over the
+   samples in view whatever their rate. A span of 0 shows the whole history,
+   with labels the value range and the time span are printed too.
+*/
+class QIndigoSparkline : public QWidget {
+	Q_OBJECT
+public:
+	explicit QIndigoSparkline(indigo_property *property, int item, double span, bool labels, QWidget *parent = nullptr);
+
+signals:
+	void clicked();
+
+protected:
+	void paintEvent(QPaintEvent *event) override;
+	void resizeEvent(QResizeEvent *event) override;
+	void mouseReleaseEvent(QMouseEvent *event) override;
+
+private:
+	indigo_property *m_property;
+	int m_item;
+	double m_span;
+	bool m_labels;
+	QVector<double> m_min;
+	QVector<double> m_max;
+};
+
+#endif // QINDIGOSPARKLINE_H
@@ -20,22 +20,37 @@
 #include <QStandardPaths>
 #include "qindigoservice.h"
 #include "qservicemodel.h"
+#include "indigoclient.h"
 #include <indigo/indigo_client.h>
 #include "conf.h"
 
 #define SERVICE_FILENAME "indigo_control_panel.services"
+#define SERVICE_CONNECT_POLL_MS 100
+#define SERVICE_CONNECT_TIMEOUT_MS 5000
+#define SERVICE_SETTLE_MS 250
+#define SERVICE_SETTLE_CHECKS 4
+#define SERVICE_WATCH_MS 2000
 
 
-QServiceModel::QServiceModel(const QByteArray &type) {
+QServiceModel::QServiceModel(const QByteArray &type) : m_type(type) {
 	m_logger = &Logger::instance();
 	m_auto_connect = true;
-	QTimer *m_timer = new QTimer(this);
-	connect(m_timer, &QTimer::timeout, this, QOverload<>::of(&QServiceModel::onTimer));
-	m_timer->start(3000);
+	connect(&IndigoClient::instance(), &IndigoClient::server_activity, this, &QServiceModel::onServerActivity);
+	m_settle_checks = 0;
+	m_settle_timer.setInterval(SERVICE_SETTLE_MS);
+	connect(&m_settle_timer, &QTimer::timeout, this, &QServiceModel::onSettleTimer);
+	m_watch_timer.setInterval(SERVICE_WATCH_MS);
+	connect(&m_watch_timer, &QTimer::timeout, this, &QServiceModel::checkSockets);
+	m_connect_timer.setInterval(SERVICE_CONNECT_POLL_MS);
+	connect(&m_connect_timer, &QTimer::timeout, this, &QServiceModel::onConnectTimer);
 	connect(&m_zeroConf, &QZeroConf::error, this, &QServiceModel::onServiceError);
 	connect(&m_zeroConf, &QZeroConf::serviceAdded, this, &QServiceModel::onServiceAdded);
 	connect(&m_zeroConf, &QZeroConf::serviceRemoved, this, &QServiceModel::onServiceRemoved);
-	m_zeroConf.startBrowser(type);
+}
+
+
+void QServiceModel::start() {
+	m_zeroConf.startBrowser(m_type);
 }
 
 
@@ -72,18 +87,106 @@ void QServiceModel::loadManualServices() {
 }
 
 
-void QServiceModel::onTimer() {
+/* A server connecting or dropping shows up as a burst of property defines
+   or deletes. The sockets are checked as soon as the burst is reported and
+   then every SERVICE_SETTLE_MS until none of them has changed for
+   SERVICE_SETTLE_CHECKS checks, as the socket may be closed well after the
+   devices of a dropped server are deleted. Servers without devices make no
+   burst at all, m_watch_timer catches their sockets every SERVICE_WATCH_MS.
+   It only runs while some service is connected or connecting.
+*/
+void QServiceModel::onServerActivity() {
+	IndigoClient::instance().activity_handled();
+	checkSockets();
+	m_settle_checks = 0;
+	m_settle_timer.start();
+}
+
+
+void QServiceModel::onSettleTimer() {
+	if (checkSockets()) m_settle_checks = 0;
+	else if (++m_settle_checks >= SERVICE_SETTLE_CHECKS) m_settle_timer.stop();
+}
+
+
+bool QServiceModel::checkSockets() {
+	bool changed = false;
 	for (auto i = mServices.constBegin(); i != mServices.constEnd(); ++i) {
 		if (i == nullptr) continue;
 		if ((*i)->m_server_entry == nullptr) continue;
+		if ((*i)->connection_state() == SERVICE_CONNECTING) continue;
 
 		int socket = (*i)->m_server_entry->socket;
 		if (socket != (*i)->prevSocket) {
 			indigo_debug("SERVICE Sockets '%s' '%s' [%d] %d\n",(*i)->m_server_entry->name, (*i)->m_server_entry->host, socket, (*i)->prevSocket);
 			(*i)->prevSocket = socket;
 			emit(serviceConnectionChange(**i));
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+
+void QServiceModel::updateWatchTimer() {
+	for (auto i = mServices.constBegin(); i != mServices.constEnd(); ++i) {
+		if ((*i)->m_server_entry != nullptr) {
+			if (!m_watch_timer.isActive()) m_watch_timer.start();
+			return;
 		}
 	}
+	m_watch_timer.stop();
+}
+
+
+/* Connections are started without waiting and checked here until each one
+   is either established or has timed out, so several servers connect in
+   parallel and the GUI thread never sleeps.
+*/
+void QServiceModel::onConnectTimer() {
+	bool pending = false;
+	for (auto i = mServices.constBegin(); i != mServices.constEnd(); ++i) {
+		QIndigoService *indigo_service = *i;
+		if (indigo_service->connection_state() != SERVICE_CONNECTING) continue;
+
+		switch (indigo_service->update_connection_state(SERVICE_CONNECT_TIMEOUT_MS)) {
+		case SERVICE_CONNECTED:
+			logService(indigo_service, "connected");
+			break;
+		case SERVICE_CONNECT_FAILED:
+			logService(indigo_service, "connection timed out");
+			emit(serviceConnectFailed(*indigo_service));
+			break;
+		default:
+			pending = true;
+			continue;
+		}
+		if (indigo_service->m_server_entry) indigo_service->prevSocket = indigo_service->m_server_entry->socket;
+		emit(serviceConnectionChange(*indigo_service));
+	}
+	if (!pending) m_connect_timer.stop();
+	updateWatchTimer();
+}
+
+
+bool QServiceModel::startConnect(QIndigoService *indigo_service) {
+	if (!indigo_service->connect()) {
+		logService(indigo_service, "connection failed");
+		emit(serviceConnectFailed(*indigo_service));
+		return false;
+	}
+	logService(indigo_service, "connecting...");
+	emit(serviceConnecting(*indigo_service));
+	if (!m_connect_timer.isActive()) m_connect_timer.start();
+	updateWatchTimer();
+	return true;
+}
+
+
+void QServiceModel::logService(QIndigoService *indigo_service, const char *what) {
+	char message[512];
+	snprintf(message, sizeof(message), "Service %s (%s:%d) %s", indigo_service->name().constData(), indigo_service->host().constData(), indigo_service->port(), what);
+	m_logger->log(nullptr, message);
 }
 
 
@@ -108,7 +211,7 @@ bool QServiceModel::addService(QByteArray name, QByteArray host, int port) {
 	mServices.append(indigo_service);
 	endInsertRows();
 
-	if (m_auto_connect) indigo_service->connect();
+	if (m_auto_connect) startConnect(indigo_service);
 	emit(serviceAdded(*indigo_service));
 	return true;
 }
@@ -123,6 +226,7 @@ bool QServiceModel::removeService(QByteArray name) {
 		mServices.removeAt(i);
 		endRemoveRows();
 		indigo_service->disconnect();
+		updateWatchTimer();
 		emit(serviceRemoved(*indigo_service));
 		delete indigo_service;
 		indigo_debug("SERVICE REMOVED [%s]\n", name.constData());
@@ -141,7 +245,7 @@ bool QServiceModel::connectService(QByteArray name) {
 	}
 	QIndigoService* indigo_service = mServices.at(i);
 	indigo_debug("CONNECTING TO SERVICE [%s] on %s:%d\n", name.constData(), indigo_service->host().constData(), indigo_service->port());
-	return indigo_service->connect();
+	return startConnect(indigo_service);
 }
 
 
@@ -154,7 +258,9 @@ bool QServiceModel::disconnectService(QByteArray name) {
 	QIndigoService* indigo_service = mServices.at(i);
 	indigo_debug("DISCONNECTING FROM SERVICE [%s] on %s:%d\n", name.constData(), indigo_service->host().constData(), indigo_service->port());
 
-	return indigo_service->disconnect();
+	bool res = indigo_service->disconnect();
+	updateWatchTimer();
+	return res;
 }
 
 
@@ -198,7 +304,7 @@ void QServiceModel::onServiceAdded(QZeroConfService service) {
 	mServices.append(indigo_service);
 	endInsertRows();
 
-	if (m_auto_connect) indigo_service->connect();
+	if (m_auto_connect) startConnect(indigo_service);
 	emit(serviceAdded(*indigo_service));
 }
 
@@ -226,6 +332,7 @@ void QServiceModel::onServiceRemoved(QZeroConfService service) {
 		mServices.removeAt(i);
 		endRemoveRows();
 		indigo_service->disconnect();
+		updateWatchTimer();
 		emit(serviceRemoved(*indigo_service));
 		delete indigo_service;
 		indigo_service = nullptr;
@@ -38,6 +38,8 @@ class QServiceModel : public QAbstractListModel
 public:
 	QServiceModel(const QByteArray &type);
 
+	void start();
+
 	void saveManualServices();
 	void loadManualServices();
 	virtual int rowCount(const QModelIndex &parent) const;
@@ -54,13 +56,18 @@ signals:
 	void serviceAdded(QIndigoService &indigo_service);
 	void serviceRemoved(QIndigoService &indigo_service);
 	void serviceConnectionChange(QIndigoService &indigo_service);
+	void serviceConnecting(QIndigoService &indigo_service);
+	void serviceConnectFailed(QIndigoService &indigo_service);
 
 private Q_SLOTS:
 	void onServiceError(QZeroConf::error_t);
 	void onServiceAdded(QZeroConfService s);
 	void onServiceUpdated(QZeroConfService s);
 	void onServiceRemoved(QZeroConfService s);
-	void onTimer();
+	void onServerActivity();
+	void onSettleTimer();
+	bool checkSockets();
+	void onConnectTimer();
 public Q_SLOTS:
 	void onRequestConnect(const QString &service);
 	void onRequestAddManualService(QIndigoService &indigo_service);
@@ -69,11 +76,19 @@ public Q_SLOTS:
 
 private:
     int findService(const QByteArray &name);
+	bool startConnect(QIndigoService *indigo_service);
+	void logService(QIndigoService *indigo_service, const char *what);
+	void updateWatchTimer();
 
 	Logger* m_logger;
 	bool m_auto_connect;
     QList<QIndigoService*> mServices;
     QZeroConf m_zeroConf;
+	QTimer m_connect_timer;
+	QTimer m_settle_timer;
+	QTimer m_watch_timer;
+	int m_settle_checks;
+	QByteArray m_type;
 };
 
 #endif // SERVICEMODEL_H
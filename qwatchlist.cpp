@@ -0,0 +1,193 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <QLabel>
+#include <QHBoxLayout>
+#include "qwatchlist.h"
+#include "qindigoproperty.h"
+#include "propertymodel.h"
+#include "conf.h"
+
+QWatchList::QWatchList(PropertyModel *model, QWidget *parent): QDialog(parent), m_model(model)
+{
+	setWindowTitle("Watch List");
+
+	QWidget *panels = new QWidget;
+	m_panel_layout = new QVBoxLayout;
+	m_panel_layout->setSpacing(10);
+	m_panel_layout->setContentsMargins(10, 10, 10, 10);
+	m_panel_layout->setSizeConstraint(QLayout::SetMinimumSize);
+	m_panel_layout->addStretch();
+	panels->setLayout(m_panel_layout);
+
+	m_scroll_area = new QScrollArea;
+	m_scroll_area->setObjectName("PROPERTY_AREA");
+	m_scroll_area->setWidgetResizable(true);
+	m_scroll_area->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+	m_scroll_area->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
+	m_scroll_area->setMinimumSize(PROPERTY_AREA_MIN_WIDTH, 480);
+	m_scroll_area->setWidget(panels);
+
+	m_button_box = new QDialogButtonBox;
+	m_close_button = m_button_box->addButton(tr("Close"), QDialogButtonBox::ActionRole);
+
+	QVBoxLayout* mainLayout = new QVBoxLayout;
+	mainLayout->addWidget(m_scroll_area);
+	mainLayout->addWidget(m_button_box);
+	setLayout(mainLayout);
+
+	QObject::connect(m_close_button, SIGNAL(clicked()), this, SLOT(close()));
+}
+
+
+QString QWatchList::key(const char *device, const char *name) {
+	QString key(device);
+	key.append('\t');
+	key.append(name);
+	return key;
+}
+
+
+bool QWatchList::pinned(indigo_property *property) const {
+	return m_pinned.contains(key(property->device, property->name));
+}
+
+
+void QWatchList::pin(indigo_property *property) {
+	QString k = key(property->device, property->name);
+	if (m_pinned.contains(k)) return;
+	m_pins.append(k);
+	m_pinned.insert(k);
+	add_panel(k, property);
+	save();
+}
+
+
+void QWatchList::unpin(const QString &key) {
+	if (!m_pinned.remove(key)) return;
+	m_pins.removeOne(key);
+	remove_panel(key);
+	save();
+}
+
+
+void QWatchList::load() {
+	char filename[PATH_LEN];
+	char line[2 * INDIGO_NAME_SIZE + 2];
+
+	snprintf(filename, PATH_LEN, "%s/%s", config_path, WATCHLIST_FILENAME);
+	FILE *file = fopen(filename, "r");
+	if (file == nullptr) return;
+	while (fgets(line, sizeof(line), file) != nullptr) {
+		QString k = QString(line).trimmed();
+		if (k.isEmpty() || m_pinned.contains(k)) continue;
+		m_pins.append(k);
+		m_pinned.insert(k);
+	}
+	fclose(file);
+	indigo_debug("Watch list loaded: %d properties\n", m_pins.size());
+}
+
+
+void QWatchList::save() {
+	char filename[PATH_LEN];
+
+	snprintf(filename, PATH_LEN, "%s/%s", config_path, WATCHLIST_FILENAME);
+	FILE *file = fopen(filename, "w");
+	if (file == nullptr) {
+		indigo_error("Can not save watch list to %s\n", filename);
+		return;
+	}
+	for (auto i = m_pins.constBegin(); i != m_pins.constEnd(); ++i) {
+		fprintf(file, "%s\n", (*i).toUtf8().constData());
+	}
+	fclose(file);
+}
+
+
+void QWatchList::on_property_define(indigo_property *property, char *message) {
+	Q_UNUSED(message);
+	QString k = key(property->device, property->name);
+	if (m_pinned.contains(k) && !m_panels.contains(k)) add_panel(k, property);
+}
+
+
+void QWatchList::on_property_delete(indigo_property *property, char *message) {
+	Q_UNUSED(message);
+	if (m_panels.isEmpty()) return;
+
+	//  An empty name deletes the group, or the whole device if the group is empty too
+	if (property->name[0] == '\0') {
+		QString prefix = key(property->device, "");
+		QString group(property->group);
+		QList<QString> keys = m_panels.keys();
+		for (auto i = keys.constBegin(); i != keys.constEnd(); ++i) {
+			if (!(*i).startsWith(prefix)) continue;
+			if (group.isEmpty() || m_panels.value(*i)->property("group").toString() == group) remove_panel(*i);
+		}
+	} else {
+		remove_panel(key(property->device, property->name));
+	}
+}
+
+
+void QWatchList::add_panel(const QString &key, indigo_property *property) {
+	QWidget *panel = new QWidget;
+	panel->setProperty("group", QString(property->group));
+	QVBoxLayout *layout = new QVBoxLayout;
+	layout->setSpacing(0);
+	layout->setContentsMargins(0, 0, 0, 0);
+	panel->setLayout(layout);
+
+	QHBoxLayout *header = new QHBoxLayout;
+	QLabel *device = new QLabel(QString("%1 . %2").arg(property->device, property->name));
+	device->setObjectName("SELECTION_TEXT");
+	header->addWidget(device, 1);
+	QPushButton *unpin_button = new QPushButton("Unpin");
+	unpin_button->setFocusPolicy(Qt::NoFocus);
+	header->addWidget(unpin_button);
+	layout->addLayout(header);
+
+	QIndigoProperty *ip = new QIndigoProperty(property);
+	layout->addWidget(ip);
+	m_model->attach_widget(ip);
+
+	//  Panels follow the pin order, the stretch stays last
+	int position = 0;
+	for (auto i = m_pins.constBegin(); i != m_pins.constEnd() && *i != key; ++i) {
+		if (m_panels.contains(*i)) position++;
+	}
+	m_panel_layout->insertWidget(position, panel);
+	m_panels.insert(key, panel);
+
+	connect(unpin_button, &QPushButton::clicked, this, [this, key]() {
+		unpin(key);
+	});
+}
+
+
+void QWatchList::remove_panel(const QString &key) {
+	QWidget *panel = m_panels.take(key);
+	if (panel == nullptr) return;
+
+	//  On delete the property is already released, detach before anything is dispatched
+	QIndigoProperty *ip = panel->findChild<QIndigoProperty*>();
+	if (ip) m_model->detach_widget(ip);
+	m_panel_layout->removeWidget(panel);
+	panel->deleteLater();
+}
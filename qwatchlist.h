@@ -0,0 +1,76 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef QWATCHLIST_H
+#define QWATCHLIST_H
+
+#include <QDialog>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QScrollArea>
+#include <QVBoxLayout>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <indigo/indigo_bus.h>
+
+#define WATCHLIST_FILENAME "indigo_control_panel.watchlist"
+
+class PropertyModel;
+
+/* Pinned properties of any device stay on the dashboard whatever is selected
+   in the tree. Their widgets are attached to the PropertyModel like the main
+   form, so only the pinned properties that are updated cost anything.
+   Pins are kept by device and property name and survive reconnects.
+*/
+class QWatchList : public QDialog
+{
+	Q_OBJECT
+public:
+	QWatchList(PropertyModel *model, QWidget *parent = 0);
+
+	static QString key(const char *device, const char *name);
+
+	bool pinned(indigo_property *property) const;
+	void pin(indigo_property *property);
+	void unpin(const QString &key);
+
+	void load();
+	void save();
+
+public slots:
+	void on_property_define(indigo_property *property, char *message);
+	void on_property_delete(indigo_property *property, char *message);
+
+private:
+	void add_panel(const QString &key, indigo_property *property);
+	void remove_panel(const QString &key);
+
+	PropertyModel* m_model;
+	QScrollArea* m_scroll_area;
+	QVBoxLayout* m_panel_layout;
+	QDialogButtonBox* m_button_box;
+	QPushButton* m_close_button;
+
+	/* Pin order is kept, panels exist only for defined properties */
+	QList<QString> m_pins;
+	QSet<QString> m_pinned;
+	QHash<QString, QWidget*> m_panels;
+};
+
+#endif // QWATCHLIST_H
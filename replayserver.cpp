@@ -0,0 +1,187 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sys/time.h>
+#include "replayserver.h"
+#include "trafficlog.h"
+#include "indigoclient.h"
+#include "logger.h"
+#include "stats.h"
+
+
+ReplayServer::ReplayServer() :
+	m_file(nullptr),
+	m_speed(1),
+	m_running(false),
+	m_processed(0),
+	m_interval_processed(0),
+	m_latency_sum_ms(0),
+	m_latency_max_ms(0),
+	m_stalls_before(0)
+{
+	pthread_mutex_init(&m_mutex, nullptr);
+	pthread_cond_init(&m_cond, nullptr);
+	connect(this, &ReplayServer::event_sent, this, &ReplayServer::on_event_sent, Qt::QueuedConnection);
+	connect(this, &ReplayServer::finished, this, &ReplayServer::on_finished, Qt::QueuedConnection);
+	connect(&m_report_timer, &QTimer::timeout, this, &ReplayServer::on_report);
+}
+
+
+bool ReplayServer::open(const char *path, double speed) {
+	m_file = traffic_open(path);
+	m_speed = speed < 0 ? 0 : speed;
+	return m_file != nullptr;
+}
+
+
+/* Called from the GUI thread, the client is not started in replay mode */
+bool ReplayServer::start() {
+	if (m_file == nullptr || m_running) return false;
+
+	m_clock.start();
+	m_stalls_before = Stats::instance().value(STAT_GUI_STALLS);
+	Stats::instance().set(STAT_GUI_LAG_MAX_MS, 0);
+	Stats::instance().start_heartbeat();
+	m_report_timer.start(REPLAY_REPORT_MS);
+
+	m_running = true;
+	if (pthread_create(&m_thread, nullptr, replay_thread, this) != 0) {
+		indigo_error("Can not start replay thread\n");
+		m_running = false;
+		stop_probe();
+		return false;
+	}
+	if (m_speed > 0)
+		indigo_log("Replaying traffic at %gx\n", m_speed);
+	else
+		indigo_log("Replaying traffic at maximum speed\n");
+	return true;
+}
+
+
+void ReplayServer::stop() {
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_running = false;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+	pthread_join(m_thread, nullptr);
+	stop_probe();
+	fclose(m_file);
+	m_file = nullptr;
+}
+
+
+/* Sleeps until the replay clock reaches due_us, false if stopped meanwhile */
+bool ReplayServer::wait_until(qint64 due_us) {
+	pthread_mutex_lock(&m_mutex);
+	while (m_running) {
+		qint64 delay_us = due_us - m_clock.nsecsElapsed() / 1000;
+		if (delay_us <= 0) break;
+		struct timeval now;
+		gettimeofday(&now, nullptr);
+		qint64 wake_us = (qint64)now.tv_sec * 1000000 + now.tv_usec + delay_us;
+		struct timespec wake;
+		wake.tv_sec = wake_us / 1000000;
+		wake.tv_nsec = (wake_us % 1000000) * 1000;
+		pthread_cond_timedwait(&m_cond, &m_mutex, &wake);
+	}
+	bool running = m_running;
+	pthread_mutex_unlock(&m_mutex);
+	return running;
+}
+
+
+void* ReplayServer::replay_thread(void *arg) {
+	ReplayServer *server = (ReplayServer *)arg;
+	IndigoClient &client = IndigoClient::instance();
+	traffic_event event;
+
+	while (traffic_read(server->m_file, &event)) {
+		const char *message = event.has_message ? event.message : nullptr;
+		bool running = server->m_speed > 0 ? server->wait_until((qint64)(event.usec / server->m_speed)) : server->wait_until(0);
+		if (running) {
+			switch (event.kind) {
+			case TRAFFIC_DEFINE:
+				client.inject_define(event.property, message);
+				break;
+			case TRAFFIC_UPDATE:
+				client.inject_update(event.property, message);
+				break;
+			case TRAFFIC_DELETE:
+				client.inject_delete(event.property, message);
+				break;
+			case TRAFFIC_MESSAGE:
+				client.inject_message(event.device, message);
+				break;
+			}
+			emit(server->event_sent(server->m_clock.nsecsElapsed() / 1000));
+		}
+		if (event.property) indigo_release_property(event.property);
+		if (!running) return nullptr;
+	}
+	emit(server->finished());
+	return nullptr;
+}
+
+
+/* Queued behind the event it follows, so the GUI has handled that one */
+void ReplayServer::on_event_sent(qint64 sent_us) {
+	double latency_ms = (m_clock.nsecsElapsed() / 1000 - sent_us) / 1000.0;
+	m_processed++;
+	m_interval_processed++;
+	m_latency_sum_ms += latency_ms;
+	if (latency_ms > m_latency_max_ms) m_latency_max_ms = latency_ms;
+}
+
+
+void ReplayServer::on_report() {
+	indigo_log("Replay: %lu events/s, %lu processed, %lld frame stalls\n", (unsigned long)(m_interval_processed * 1000 / REPLAY_REPORT_MS), m_processed, (long long)(Stats::instance().value(STAT_GUI_STALLS) - m_stalls_before));
+	m_interval_processed = 0;
+}
+
+
+void ReplayServer::on_finished() {
+	stop_probe();
+	report("finished");
+}
+
+
+/* Once per run, the replay may finish on its own and be stopped later */
+void ReplayServer::stop_probe() {
+	if (!m_report_timer.isActive()) return;
+	m_report_timer.stop();
+	Stats::instance().stop_heartbeat();
+}
+
+
+void ReplayServer::report(const char *phase) {
+	char message[INDIGO_VALUE_SIZE];
+	double seconds = m_clock.elapsed() / 1000.0;
+	snprintf(message, sizeof(message),
+		"Replay %s: %lu events in %.1f s (%.0f events/s), queue latency %.2f ms avg %.2f ms max, %lld frame stalls (longest %lld ms late)",
+		phase, m_processed, seconds, seconds > 0 ? m_processed / seconds : 0,
+		m_processed ? m_latency_sum_ms / m_processed : 0, m_latency_max_ms,
+		(long long)(Stats::instance().value(STAT_GUI_STALLS) - m_stalls_before), (long long)Stats::instance().value(STAT_GUI_LAG_MAX_MS));
+	indigo_log("%s\n", message);
+	Logger::instance().log(nullptr, message);
+}
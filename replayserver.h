@@ -0,0 +1,92 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef REPLAYSERVER_H
+#define REPLAYSERVER_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#define REPLAY_REPORT_MS 1000
+
+
+/* Stand-in for an INDIGO server. Plays a traffic log recorded by TrafficLog
+   into the client callbacks from its own thread, as the bus would, so the
+   whole GUI path runs without hardware or network. Speed 1 keeps the
+   recorded timing, N plays N times faster and 0 as fast as possible.
+
+   After each event the replay thread queues a marker to the GUI thread,
+   which arrives once the GUI has handled the event before it. That gives
+   the events processed per second and the queue latency. Frame stalls are
+   taken from the GUI heartbeat in Stats.
+*/
+class ReplayServer : public QObject {
+	Q_OBJECT
+public:
+	static ReplayServer& instance();
+
+	bool open(const char *path, double speed);
+	bool loaded() const { return m_file != nullptr; }
+	bool start();
+	void stop();
+
+signals:
+	void event_sent(qint64 sent_us);
+	void finished();
+
+private slots:
+	void on_event_sent(qint64 sent_us);
+	void on_report();
+	void on_finished();
+
+private:
+	ReplayServer();
+
+	static void* replay_thread(void *arg);
+	bool wait_until(qint64 due_us);
+	void report(const char *phase);
+	void stop_probe();
+
+	FILE *m_file;
+	double m_speed;
+	pthread_t m_thread;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	bool m_running;
+
+	/* GUI thread only */
+	QElapsedTimer m_clock;
+	QTimer m_report_timer;
+	unsigned long m_processed;
+	unsigned long m_interval_processed;
+	double m_latency_sum_ms;
+	double m_latency_max_ms;
+	qint64 m_stalls_before;
+};
+
+inline ReplayServer& ReplayServer::instance() {
+	static ReplayServer* me = nullptr;
+	if (!me) me = new ReplayServer();
+	return *me;
+}
+
+#endif // REPLAYSERVER_H
@@ -0,0 +1,354 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QtEndian>
+#include "sessionarchive.h"
+
+
+static unsigned long long now_usec() {
+	struct timeval now;
+	gettimeofday(&now, nullptr);
+	return now.tv_sec * 1000000ULL + now.tv_usec;
+}
+
+static void put_u8(QByteArray &out, unsigned char value) {
+	out.append((char)value);
+}
+
+static void put_u16(QByteArray &out, quint16 value) {
+	value = qToLittleEndian(value);
+	out.append((const char *)&value, sizeof(value));
+}
+
+static void put_u32(QByteArray &out, quint32 value) {
+	value = qToLittleEndian(value);
+	out.append((const char *)&value, sizeof(value));
+}
+
+static void put_u64(QByteArray &out, quint64 value) {
+	value = qToLittleEndian(value);
+	out.append((const char *)&value, sizeof(value));
+}
+
+static void put_str(QByteArray &out, const char *value) {
+	size_t length = strnlen(value, INDIGO_NAME_SIZE);
+	put_u16(out, (quint16)length);
+	out.append(value, (int)length);
+}
+
+static void put_varint(QByteArray &out, quint64 value) {
+	while (value >= 0x80) {
+		out.append((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.append((char)value);
+}
+
+static quint64 zigzag(qint64 value) {
+	return ((quint64)value << 1) ^ (quint64)(value >> 63);
+}
+
+static quint64 value_bits(indigo_property_type type, double value) {
+	if (type != INDIGO_NUMBER_VECTOR) return (quint64)(qint64)value;
+	quint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+
+SessionArchive::SessionArchive() {
+	m_file = nullptr;
+	m_path[0] = '\0';
+	m_running = false;
+	m_start = 0;
+	m_full_head = m_full_tail = nullptr;
+	m_free = nullptr;
+	m_samples = 0;
+	pthread_mutex_init(&m_mutex, nullptr);
+	pthread_cond_init(&m_cond, nullptr);
+}
+
+
+/* Newest first, so the sessions that go are always the oldest ones */
+void SessionArchive::prune(const char *directory) {
+	QDir dir(directory);
+	QFileInfoList sessions = dir.entryInfoList(QStringList("session_*.icparch"), QDir::Files, QDir::Time);
+	QDateTime oldest = QDateTime::currentDateTime().addDays(-ARCHIVE_KEEP_DAYS);
+	qint64 total = 0;
+	for (const QFileInfo &session : sessions) {
+		total += session.size();
+		if (session.lastModified() >= oldest && total <= (qint64)ARCHIVE_KEEP_MB * 1024 * 1024) continue;
+		if (dir.remove(session.fileName()))
+			indigo_debug("Session archive '%s' pruned\n", session.fileName().toUtf8().constData());
+		else
+			indigo_error("Can not remove session archive '%s'\n", session.fileName().toUtf8().constData());
+	}
+}
+
+
+bool SessionArchive::start(const char *directory) {
+	if (m_running) return true;
+
+	QDir dir("");
+	dir.mkpath(directory);
+	prune(directory);
+	time_t now = time(nullptr);
+	struct tm local;
+	localtime_r(&now, &local);
+	char name[64];
+	strftime(name, sizeof(name), "session_%Y-%m-%d_%H-%M-%S.icparch", &local);
+	snprintf(m_path, PATH_LEN, "%s/%s", directory, name);
+
+	FILE *file = fopen(m_path, "wb");
+	if (file == nullptr) {
+		indigo_error("Can not create session archive '%s': %s\n", m_path, strerror(errno));
+		return false;
+	}
+	m_start = now_usec();
+	quint32 version = qToLittleEndian<quint32>(ARCHIVE_VERSION);
+	quint64 start = qToLittleEndian<quint64>(m_start);
+	fwrite(ARCHIVE_MAGIC, 8, 1, file);
+	fwrite(&version, sizeof(version), 1, file);
+	fwrite(&start, sizeof(start), 1, file);
+
+	pthread_mutex_lock(&m_mutex);
+	m_file = file;
+	m_samples = 0;
+	m_running = true;
+	pthread_mutex_unlock(&m_mutex);
+	if (pthread_create(&m_thread, nullptr, writer_thread, this) != 0) {
+		indigo_error("Can not start session archive thread\n");
+		m_running = false;
+		fclose(m_file);
+		m_file = nullptr;
+		return false;
+	}
+	indigo_log("Archiving property history to '%s'\n", m_path);
+	return true;
+}
+
+
+/* Everything recorded so far is written before the archive is closed */
+void SessionArchive::stop() {
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	m_running = false;
+	pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+	pthread_join(m_thread, nullptr);
+
+	fclose(m_file);
+	m_file = nullptr;
+	for (auto i = m_series.constBegin(); i != m_series.constEnd(); ++i) free(*i);
+	m_series.clear();
+	m_series_index.clear();
+	while (m_free) {
+		archive_block *block = m_free;
+		m_free = block->next;
+		free(block);
+	}
+	indigo_log("Session archive closed, %lu samples recorded\n", m_samples);
+}
+
+
+/* Called with the mutex held. Known series are looked up without allocating. */
+archive_series* SessionArchive::find_series(indigo_property *property, indigo_item *item) {
+	char key[3 * INDIGO_NAME_SIZE + 2];
+	int length = snprintf(key, sizeof(key), "%s\t%s\t%s", property->device, property->name, item->name);
+	if (length >= (int)sizeof(key)) length = sizeof(key) - 1;
+	archive_series *series = m_series_index.value(QByteArray::fromRawData(key, length), nullptr);
+	if (series) return series;
+
+	series = (archive_series *)calloc(1, sizeof(archive_series));
+	series->id = m_series.size();
+	series->type = property->type;
+	strncpy(series->device, property->device, INDIGO_NAME_SIZE - 1);
+	strncpy(series->property, property->name, INDIGO_NAME_SIZE - 1);
+	strncpy(series->item, item->name, INDIGO_NAME_SIZE - 1);
+	m_series.append(series);
+	m_series_index.insert(QByteArray(key, length), series);
+	return series;
+}
+
+
+/* Called with the mutex held */
+archive_block* SessionArchive::take_block(archive_series *series) {
+	archive_block *block = m_free;
+	if (block) m_free = block->next;
+	else block = (archive_block *)malloc(sizeof(archive_block));
+	block->series = series->id;
+	block->type = series->type;
+	block->count = 0;
+	block->next = nullptr;
+	return block;
+}
+
+
+void SessionArchive::record(indigo_property *property) {
+	if (!m_running) return;
+	if (property->type != INDIGO_NUMBER_VECTOR && property->type != INDIGO_SWITCH_VECTOR && property->type != INDIGO_LIGHT_VECTOR) return;
+
+	pthread_mutex_lock(&m_mutex);
+	if (!m_running) {
+		pthread_mutex_unlock(&m_mutex);
+		return;
+	}
+	unsigned long long usec = now_usec() - m_start;
+	bool full = false;
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = &property->items[i];
+		double value;
+		if (property->type == INDIGO_NUMBER_VECTOR) value = item->number.value;
+		else if (property->type == INDIGO_SWITCH_VECTOR) value = item->sw.value ? 1 : 0;
+		else value = item->light.value;
+
+		archive_series *series = find_series(property, item);
+		if (series->has_last && series->last == value) continue;
+		series->last = value;
+		series->has_last = true;
+
+		if (series->block == nullptr) series->block = take_block(series);
+		archive_block *block = series->block;
+		block->usec[block->count] = usec;
+		block->value[block->count] = value;
+		m_samples++;
+		if (++block->count == ARCHIVE_BLOCK_SAMPLES) {
+			if (m_full_tail) m_full_tail->next = block;
+			else m_full_head = block;
+			m_full_tail = block;
+			series->block = nullptr;
+			full = true;
+		}
+	}
+	if (full) pthread_cond_signal(&m_cond);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void* SessionArchive::writer_thread(void *arg) {
+	SessionArchive *archive = (SessionArchive *)arg;
+	struct timespec next_flush;
+	clock_gettime(CLOCK_REALTIME, &next_flush);
+	next_flush.tv_sec += ARCHIVE_FLUSH_S;
+
+	pthread_mutex_lock(&archive->m_mutex);
+	while (true) {
+		bool flush = false;
+		if (archive->m_running && archive->m_full_head == nullptr) {
+			if (pthread_cond_timedwait(&archive->m_cond, &archive->m_mutex, &next_flush) == ETIMEDOUT) flush = true;
+		}
+		bool stopping = !archive->m_running;
+
+		/* new series are described before their first block */
+		QList<archive_series*> series;
+		for (auto i = archive->m_series.constBegin(); i != archive->m_series.constEnd(); ++i) {
+			if (!(*i)->written) {
+				(*i)->written = true;
+				series.append(*i);
+			}
+		}
+
+		archive_block *batch = archive->m_full_head;
+		archive_block *last = archive->m_full_tail;
+		archive->m_full_head = archive->m_full_tail = nullptr;
+		if (flush || stopping) {
+			for (auto i = archive->m_series.constBegin(); i != archive->m_series.constEnd(); ++i) {
+				archive_block *block = (*i)->block;
+				if (block == nullptr) continue;
+				(*i)->block = nullptr;
+				if (last) last->next = block;
+				else batch = block;
+				last = block;
+			}
+			clock_gettime(CLOCK_REALTIME, &next_flush);
+			next_flush.tv_sec += ARCHIVE_FLUSH_S;
+		}
+		pthread_mutex_unlock(&archive->m_mutex);
+
+		/* the series are not changed once created, they are read without the lock */
+		for (auto i = series.constBegin(); i != series.constEnd(); ++i) archive->write_series(*i);
+		for (archive_block *block = batch; block; block = block->next) archive->write_block(block);
+		if (!series.isEmpty() || batch) fflush(archive->m_file);
+
+		pthread_mutex_lock(&archive->m_mutex);
+		if (last) {
+			last->next = archive->m_free;
+			archive->m_free = batch;
+		}
+		if (stopping) break;
+	}
+	pthread_mutex_unlock(&archive->m_mutex);
+	return nullptr;
+}
+
+
+void SessionArchive::write_series(archive_series *series) {
+	m_payload.resize(0);
+	put_u32(m_payload, series->id);
+	put_u8(m_payload, series->type);
+	put_str(m_payload, series->device);
+	put_str(m_payload, series->property);
+	put_str(m_payload, series->item);
+	write_record(ARCHIVE_SERIES);
+}
+
+
+void SessionArchive::write_block(archive_block *block) {
+	m_columns.resize(0);
+	unsigned long long time = block->usec[0];
+	for (int i = 0; i < block->count; i++) {
+		put_varint(m_columns, block->usec[i] - time);
+		time = block->usec[i];
+	}
+	quint64 previous = 0;
+	for (int i = 0; i < block->count; i++) {
+		quint64 bits = value_bits(block->type, block->value[i]);
+		put_varint(m_columns, zigzag((qint64)(bits - previous)));
+		previous = bits;
+	}
+
+	m_payload.resize(0);
+	put_u32(m_payload, block->series);
+	put_u32(m_payload, block->count);
+	put_u64(m_payload, block->usec[0]);
+	put_u64(m_payload, block->usec[block->count - 1]);
+	m_payload.append(qCompress(m_columns));
+	write_record(ARCHIVE_BLOCK);
+}
+
+
+void SessionArchive::write_record(archive_kind kind) {
+	unsigned char header[ARCHIVE_RECORD_HEADER];
+	header[0] = (unsigned char)kind;
+	qToLittleEndian<quint32>(m_payload.size(), header + 1);
+	if (fwrite(header, sizeof(header), 1, m_file) != 1 ||
+	    fwrite(m_payload.constData(), m_payload.size(), 1, m_file) != 1) {
+		indigo_error("Can not write session archive '%s': %s\n", m_path, strerror(errno));
+	}
+}
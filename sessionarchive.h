@@ -0,0 +1,145 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef SESSIONARCHIVE_H
+#define SESSIONARCHIVE_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <indigo/indigo_bus.h>
+#include "conf.h"
+
+/* Session archive layout, all numbers little endian:
+
+   header:  "ICPARCHV" u32 version, u64 session start (microseconds since the epoch)
+   record:  u8 kind, u32 payload size, payload
+   series:  u32 id, u8 property type, str device, str property, str item
+   block:   u32 series, u32 count, u64 first, u64 last, compressed columns
+   columns: count varint time deltas, then count varint value deltas
+
+   Times are microseconds since the session start, the first time delta is
+   taken from the block first time. Number values are kept as the zigzag
+   delta of their IEEE 754 bit patterns, switch values and light states as
+   the zigzag delta of the value. The columns are compressed by qCompress().
+   Records are only appended, a record cut short ends the archive for the
+   reader. str is u16 length followed by the bytes.
+*/
+#define ARCHIVE_MAGIC "ICPARCHV"
+#define ARCHIVE_VERSION 1
+#define ARCHIVE_HEADER_SIZE 20
+#define ARCHIVE_RECORD_HEADER 5
+#define ARCHIVE_BLOCK_HEADER 24
+#define ARCHIVE_DIRECTORY "indigo_control_panel.archive"
+
+/* Older sessions are deleted when a new one starts, beyond this age or
+   once all of them together would take more than ARCHIVE_KEEP_MB
+*/
+#define ARCHIVE_KEEP_DAYS 30
+#define ARCHIVE_KEEP_MB 512
+
+/* Samples per block, open blocks are written every ARCHIVE_FLUSH_S anyway */
+#define ARCHIVE_BLOCK_SAMPLES 1024
+#define ARCHIVE_FLUSH_S 10
+
+typedef enum {
+	ARCHIVE_SERIES = 1,
+	ARCHIVE_BLOCK = 2
+} archive_kind;
+
+struct archive_block {
+	quint32 series;
+	indigo_property_type type;
+	int count;
+	unsigned long long usec[ARCHIVE_BLOCK_SAMPLES];
+	double value[ARCHIVE_BLOCK_SAMPLES];
+	archive_block *next;
+};
+
+struct archive_series {
+	quint32 id;
+	indigo_property_type type;
+	char device[INDIGO_NAME_SIZE];
+	char property[INDIGO_NAME_SIZE];
+	char item[INDIGO_NAME_SIZE];
+	double last;
+	bool has_last;
+	bool written;
+	archive_block *block;
+};
+
+
+/* Archives the number, switch and light changes seen by the client callbacks,
+   one file per session. record() is called on the indigo threads, it only
+   copies the items that changed into the open block of their series. Full
+   blocks, and every ARCHIVE_FLUSH_S seconds the open ones, are encoded,
+   compressed and appended by the archive thread. Blocks are reused.
+   Sessions past ARCHIVE_KEEP_DAYS or ARCHIVE_KEEP_MB are pruned on start.
+*/
+class SessionArchive {
+public:
+	static SessionArchive& instance();
+
+	bool start(const char *directory);
+	void stop();
+	bool running() const { return m_running; }
+
+	void record(indigo_property *property);
+
+	unsigned long samples_recorded() const { return m_samples; }
+
+private:
+	SessionArchive();
+
+	static void* writer_thread(void *arg);
+	static void prune(const char *directory);
+	archive_series* find_series(indigo_property *property, indigo_item *item);
+	archive_block* take_block(archive_series *series);
+	void write_series(archive_series *series);
+	void write_block(archive_block *block);
+	void write_record(archive_kind kind);
+
+	FILE *m_file;
+	char m_path[PATH_LEN];
+	pthread_t m_thread;
+	pthread_mutex_t m_mutex;
+	pthread_cond_t m_cond;
+	bool m_running;
+	unsigned long long m_start;
+
+	QHash<QByteArray, archive_series*> m_series_index;
+	QList<archive_series*> m_series;
+	archive_block *m_full_head;
+	archive_block *m_full_tail;
+	archive_block *m_free;
+
+	/* Used by the archive thread only */
+	QByteArray m_columns;
+	QByteArray m_payload;
+	unsigned long m_samples;
+};
+
+inline SessionArchive& SessionArchive::instance() {
+	static SessionArchive* me = nullptr;
+	if (!me) me = new SessionArchive();
+	return *me;
+}
+
+#endif // SESSIONARCHIVE_H
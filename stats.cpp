@@ -0,0 +1,130 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <string.h>
+#include "stats.h"
+
+#define SLOT_EMPTY 0
+#define SLOT_CLAIMED 1
+#define SLOT_READY 2
+
+static const char *counter_names[STAT_COUNT] = {
+	"Defined properties",
+	"Updated properties",
+	"Deleted properties",
+	"Messages",
+	"Queued property signals",
+	"Cached previews",
+	"Cache hits",
+	"Cache misses",
+	"Cache evictions",
+	"Decoded previews",
+	"Devices",
+	"Groups",
+	"Properties",
+	"Items",
+	"Event loop lag (ms)",
+	"Event loop lag max (ms)",
+	"Stalls"
+};
+
+
+Stats::Stats() : m_heartbeat_users(0) {
+	for (int i = 0; i < STATS_MAX_DEVICES; i++) {
+		m_devices[i].name[0] = '\0';
+	}
+	connect(&m_heartbeat, &QTimer::timeout, this, &Stats::on_heartbeat);
+}
+
+
+const char* Stats::name(stat_counter counter) {
+	return counter_names[counter];
+}
+
+
+QString Stats::bucket_name(int bucket) {
+	if (bucket == STATS_DECODE_BUCKETS - 1)
+		return QString(">= %1 ms").arg(1 << (bucket - 1));
+	return QString("< %1 ms").arg(1 << bucket);
+}
+
+
+void Stats::device_event(const char *device) {
+	unsigned int hash = 2166136261u;
+	for (const char *c = device; *c; c++) hash = (hash ^ (unsigned char)*c) * 16777619u;
+
+	for (int probe = 0; probe < STATS_MAX_DEVICES; probe++) {
+		device_slot &slot = m_devices[(hash + probe) % STATS_MAX_DEVICES];
+		int state = slot.state.loadAcquire();
+		if (state == SLOT_EMPTY && slot.state.testAndSetAcquire(SLOT_EMPTY, SLOT_CLAIMED)) {
+			strncpy(slot.name, device, INDIGO_NAME_SIZE - 1);
+			slot.state.storeRelease(SLOT_READY);
+			slot.events.fetchAndAddRelaxed(1);
+			return;
+		}
+		/* someone is writing the name right now, it takes a few instructions */
+		while ((state = slot.state.loadAcquire()) == SLOT_CLAIMED);
+		if (!strncmp(slot.name, device, INDIGO_NAME_SIZE)) {
+			slot.events.fetchAndAddRelaxed(1);
+			return;
+		}
+	}
+}
+
+
+void Stats::decode_time(double ms) {
+	int bucket = 0;
+	while (bucket < STATS_DECODE_BUCKETS - 1 && ms >= (1 << bucket)) bucket++;
+	m_decode_buckets[bucket].fetchAndAddRelaxed(1);
+	m_counters[STAT_PREVIEW_DECODES].fetchAndAddRelaxed(1);
+}
+
+
+QList<QPair<QString, qint64>> Stats::device_events() const {
+	QList<QPair<QString, qint64>> result;
+	for (int i = 0; i < STATS_MAX_DEVICES; i++) {
+		const device_slot &slot = m_devices[i];
+		if (slot.state.loadAcquire() == SLOT_READY)
+			result.append(qMakePair(QString(slot.name), slot.events.loadAcquire()));
+	}
+	return result;
+}
+
+
+void Stats::start_heartbeat() {
+	if (m_heartbeat_users++) return;
+	m_last_beat.start();
+	m_heartbeat.start(STATS_HEARTBEAT_MS);
+}
+
+
+void Stats::stop_heartbeat() {
+	if (m_heartbeat_users == 0 || --m_heartbeat_users) return;
+	m_heartbeat.stop();
+	set(STAT_GUI_LAG_MS, 0);
+}
+
+
+void Stats::on_heartbeat() {
+	qint64 lag = m_last_beat.restart() - STATS_HEARTBEAT_MS;
+	if (lag < 0) lag = 0;
+	set(STAT_GUI_LAG_MS, lag);
+	if (lag > value(STAT_GUI_LAG_MAX_MS)) set(STAT_GUI_LAG_MAX_MS, lag);
+	if (lag + STATS_HEARTBEAT_MS > STATS_STALL_MS) add(STAT_GUI_STALLS);
+}
@@ -0,0 +1,134 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#include <QTimer>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <indigo/indigo_bus.h>
+
+/* Devices with their own event counter, the rest only count in the totals */
+#define STATS_MAX_DEVICES 64
+
+/* Decode time buckets: < 1 ms, < 2 ms, < 4 ms ... < 1024 ms and the rest */
+#define STATS_DECODE_BUCKETS 12
+
+/* GUI heartbeat, one beat per frame. A gap longer than STATS_STALL_MS
+   between two beats is a stall, as the replay probe counted them before.
+*/
+#define STATS_HEARTBEAT_MS 16
+#define STATS_STALL_MS 50
+
+typedef enum {
+	STAT_BUS_DEFINES = 0,
+	STAT_BUS_UPDATES,
+	STAT_BUS_DELETES,
+	STAT_BUS_MESSAGES,
+	STAT_QUEUED_SIGNALS,
+	STAT_PREVIEW_CACHE_SIZE,
+	STAT_PREVIEW_CACHE_HITS,
+	STAT_PREVIEW_CACHE_MISSES,
+	STAT_PREVIEW_CACHE_EVICTIONS,
+	STAT_PREVIEW_DECODES,
+	STAT_TREE_DEVICES,
+	STAT_TREE_GROUPS,
+	STAT_TREE_PROPERTIES,
+	STAT_TREE_ITEMS,
+	STAT_GUI_LAG_MS,
+	STAT_GUI_LAG_MAX_MS,
+	STAT_GUI_STALLS,
+	STAT_COUNT
+} stat_counter;
+
+
+/* Process wide counters. Updates are single relaxed atomic adds, so they
+   can be called from the indigo threads and hot paths without locking.
+   Devices get a slot on their first event in a fixed open addressed
+   table, a slot is never freed.
+*/
+class Stats : public QObject {
+	Q_OBJECT
+public:
+	static Stats& instance();
+
+	void add(stat_counter counter, qint64 value = 1) {
+		m_counters[counter].fetchAndAddRelaxed(value);
+	}
+
+	void set(stat_counter counter, qint64 value) {
+		m_counters[counter].storeRelease(value);
+	}
+
+	qint64 value(stat_counter counter) const {
+		return m_counters[counter].loadAcquire();
+	}
+
+	void device_event(const char *device);
+	void decode_time(double ms);
+
+	qint64 decode_bucket(int bucket) const {
+		return m_decode_buckets[bucket].loadAcquire();
+	}
+
+	QList<QPair<QString, qint64>> device_events() const;
+
+	static const char* name(stat_counter counter);
+	static QString bucket_name(int bucket);
+
+	/* Measures the GUI event loop lag while at least one user (the
+	   diagnostics window, a replay) wants it. Call from the GUI thread.
+	*/
+	void start_heartbeat();
+	void stop_heartbeat();
+
+private slots:
+	void on_heartbeat();
+
+private:
+	struct device_slot {
+		QAtomicInt state;
+		char name[INDIGO_NAME_SIZE];
+		QAtomicInteger<qint64> events;
+	};
+
+	Stats();
+
+	QAtomicInteger<qint64> m_counters[STAT_COUNT];
+	QAtomicInteger<qint64> m_decode_buckets[STATS_DECODE_BUCKETS];
+	device_slot m_devices[STATS_MAX_DEVICES];
+
+	QTimer m_heartbeat;
+	QElapsedTimer m_last_beat;
+	int m_heartbeat_users;
+};
+
+inline Stats& Stats::instance() {
+	static Stats* me = nullptr;
+	if (!me) me = new Stats();
+	return *me;
+}
+
+#endif // STATS_H
@@ -0,0 +1,380 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <QtEndian>
+#include "trafficlog.h"
+
+#define TRAFFIC_RECORD_HEADER 13
+#define TRAFFIC_MAX_PAYLOAD (16 * 1024 * 1024)
+
+
+static void put_u8(QByteArray &out, unsigned char value) {
+	out.append((char)value);
+}
+
+static void put_u16(QByteArray &out, quint16 value) {
+	value = qToLittleEndian(value);
+	out.append((const char *)&value, sizeof(value));
+}
+
+static void put_u32(QByteArray &out, quint32 value) {
+	value = qToLittleEndian(value);
+	out.append((const char *)&value, sizeof(value));
+}
+
+static void put_f64(QByteArray &out, double value) {
+	quint64 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	bits = qToLittleEndian(bits);
+	out.append((const char *)&bits, sizeof(bits));
+}
+
+static void put_str(QByteArray &out, const char *value) {
+	size_t length = value ? strnlen(value, INDIGO_VALUE_SIZE) : 0;
+	put_u16(out, (quint16)length);
+	out.append(value, (int)length);
+}
+
+
+/* Reading side, every get_ fails once the payload runs short */
+struct traffic_cursor {
+	const unsigned char *data;
+	size_t size;
+	size_t pos;
+	bool ok;
+};
+
+static const unsigned char* take(traffic_cursor &in, size_t size) {
+	if (!in.ok || in.pos + size > in.size) {
+		in.ok = false;
+		return nullptr;
+	}
+	const unsigned char *data = in.data + in.pos;
+	in.pos += size;
+	return data;
+}
+
+static unsigned char get_u8(traffic_cursor &in) {
+	const unsigned char *data = take(in, 1);
+	return data ? *data : 0;
+}
+
+static quint16 get_u16(traffic_cursor &in) {
+	const unsigned char *data = take(in, 2);
+	return data ? qFromLittleEndian<quint16>(data) : 0;
+}
+
+static quint32 get_u32(traffic_cursor &in) {
+	const unsigned char *data = take(in, 4);
+	return data ? qFromLittleEndian<quint32>(data) : 0;
+}
+
+static double get_f64(traffic_cursor &in) {
+	const unsigned char *data = take(in, 8);
+	if (data == nullptr) return 0;
+	quint64 bits = qFromLittleEndian<quint64>(data);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static void get_str(traffic_cursor &in, char *value, size_t size) {
+	quint16 length = get_u16(in);
+	const unsigned char *data = take(in, length);
+	if (data == nullptr) length = 0;
+	if (length >= size) length = size - 1;
+	if (length) memcpy(value, data, length);
+	value[length] = '\0';
+}
+
+
+FILE* traffic_open(const char *path) {
+	FILE *file = fopen(path, "rb");
+	if (file == nullptr) {
+		indigo_error("Can not open traffic log '%s': %s\n", path, strerror(errno));
+		return nullptr;
+	}
+	char magic[8];
+	unsigned char version[4];
+	if (fread(magic, sizeof(magic), 1, file) != 1 || memcmp(magic, TRAFFIC_MAGIC, sizeof(magic)) ||
+	    fread(version, sizeof(version), 1, file) != 1 || qFromLittleEndian<quint32>(version) != TRAFFIC_VERSION) {
+		indigo_error("'%s' is not a traffic log of version %d\n", path, TRAFFIC_VERSION);
+		fclose(file);
+		return nullptr;
+	}
+	return file;
+}
+
+
+static indigo_property* read_property(traffic_cursor &in) {
+	indigo_property_type type = (indigo_property_type)get_u8(in);
+	indigo_property_state state = (indigo_property_state)get_u8(in);
+	indigo_property_perm perm = (indigo_property_perm)get_u8(in);
+	indigo_rule rule = (indigo_rule)get_u8(in);
+	int count = get_u16(in);
+	char device[INDIGO_NAME_SIZE], name[INDIGO_NAME_SIZE], group[INDIGO_NAME_SIZE], label[INDIGO_VALUE_SIZE];
+	get_str(in, device, sizeof(device));
+	get_str(in, name, sizeof(name));
+	get_str(in, group, sizeof(group));
+	get_str(in, label, sizeof(label));
+	if (!in.ok) return nullptr;
+
+	indigo_property *property = nullptr;
+	switch (type) {
+	case INDIGO_TEXT_VECTOR:
+		property = indigo_init_text_property(nullptr, device, name, group, label, state, perm, count);
+		break;
+	case INDIGO_NUMBER_VECTOR:
+		property = indigo_init_number_property(nullptr, device, name, group, label, state, perm, count);
+		break;
+	case INDIGO_SWITCH_VECTOR:
+		property = indigo_init_switch_property(nullptr, device, name, group, label, state, perm, rule, count);
+		break;
+	case INDIGO_LIGHT_VECTOR:
+		property = indigo_init_light_property(nullptr, device, name, group, label, state, count);
+		break;
+	case INDIGO_BLOB_VECTOR:
+		property = indigo_init_blob_property(nullptr, device, name, group, label, state, count);
+		break;
+	}
+	return property;
+}
+
+
+static void read_items(traffic_cursor &in, indigo_property *property) {
+	for (int i = 0; i < property->count; i++) {
+		indigo_item *item = &property->items[i];
+		get_str(in, item->name, sizeof(item->name));
+		get_str(in, item->label, sizeof(item->label));
+		switch (property->type) {
+		case INDIGO_TEXT_VECTOR:
+			get_str(in, item->text.value, sizeof(item->text.value));
+			break;
+		case INDIGO_NUMBER_VECTOR:
+			get_str(in, item->number.format, sizeof(item->number.format));
+			item->number.min = get_f64(in);
+			item->number.max = get_f64(in);
+			item->number.step = get_f64(in);
+			item->number.value = get_f64(in);
+			item->number.target = get_f64(in);
+			break;
+		case INDIGO_SWITCH_VECTOR:
+			item->sw.value = get_u8(in) != 0;
+			break;
+		case INDIGO_LIGHT_VECTOR:
+			item->light.value = (indigo_property_state)get_u8(in);
+			break;
+		case INDIGO_BLOB_VECTOR:
+			get_str(in, item->blob.format, sizeof(item->blob.format));
+			get_u32(in);
+			item->blob.value = nullptr;
+			item->blob.size = 0;
+			item->blob.url[0] = '\0';
+			break;
+		}
+	}
+}
+
+
+bool traffic_read(FILE *file, traffic_event *event) {
+	unsigned char header[TRAFFIC_RECORD_HEADER];
+	if (fread(header, sizeof(header), 1, file) != 1) return false;
+
+	event->kind = (traffic_kind)header[0];
+	event->usec = qFromLittleEndian<quint64>(header + 1);
+	quint32 size = qFromLittleEndian<quint32>(header + 9);
+	event->property = nullptr;
+	event->device[0] = '\0';
+	event->message[0] = '\0';
+	if (size > TRAFFIC_MAX_PAYLOAD) {
+		indigo_error("Damaged traffic log record (%u bytes)\n", size);
+		return false;
+	}
+
+	QByteArray payload(size, '\0');
+	if (size && fread(payload.data(), size, 1, file) != 1) return false;
+	traffic_cursor in = { (const unsigned char *)payload.constData(), size, 0, true };
+
+	switch (event->kind) {
+	case TRAFFIC_DEFINE:
+	case TRAFFIC_UPDATE:
+		event->property = read_property(in);
+		if (event->property == nullptr) break;
+		get_str(in, event->message, sizeof(event->message));
+		read_items(in, event->property);
+		break;
+	case TRAFFIC_DELETE: {
+		char device[INDIGO_NAME_SIZE], name[INDIGO_NAME_SIZE], group[INDIGO_NAME_SIZE];
+		get_str(in, device, sizeof(device));
+		get_str(in, name, sizeof(name));
+		get_str(in, group, sizeof(group));
+		get_str(in, event->message, sizeof(event->message));
+		if (in.ok) event->property = indigo_init_text_property(nullptr, device, name, group, "", INDIGO_IDLE_STATE, INDIGO_RO_PERM, 0);
+		break;
+	}
+	case TRAFFIC_MESSAGE:
+		get_str(in, event->device, sizeof(event->device));
+		get_str(in, event->message, sizeof(event->message));
+		break;
+	default:
+		in.ok = false;
+	}
+
+	if (!in.ok || (event->kind != TRAFFIC_MESSAGE && event->property == nullptr)) {
+		indigo_error("Damaged traffic log record\n");
+		if (event->property) indigo_release_property(event->property);
+		event->property = nullptr;
+		return false;
+	}
+	event->has_message = event->message[0] != '\0';
+	if (event->property) strncpy(event->device, event->property->device, INDIGO_NAME_SIZE);
+	return true;
+}
+
+
+TrafficLog::TrafficLog() : m_file(nullptr), m_events(0) {
+	pthread_mutex_init(&m_mutex, nullptr);
+	m_start.tv_sec = 0;
+	m_start.tv_usec = 0;
+}
+
+
+bool TrafficLog::open(const char *path) {
+	FILE *file = fopen(path, "wb");
+	if (file == nullptr) {
+		indigo_error("Can not create traffic log '%s': %s\n", path, strerror(errno));
+		return false;
+	}
+	quint32 version = qToLittleEndian<quint32>(TRAFFIC_VERSION);
+	fwrite(TRAFFIC_MAGIC, 8, 1, file);
+	fwrite(&version, sizeof(version), 1, file);
+
+	pthread_mutex_lock(&m_mutex);
+	gettimeofday(&m_start, nullptr);
+	m_events = 0;
+	m_file = file;
+	pthread_mutex_unlock(&m_mutex);
+	return true;
+}
+
+
+void TrafficLog::close() {
+	pthread_mutex_lock(&m_mutex);
+	if (m_file) {
+		fclose(m_file);
+		m_file = nullptr;
+		indigo_log("Traffic log closed, %lu events recorded\n", m_events);
+	}
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void TrafficLog::record(traffic_kind kind, indigo_property *property, const char *message) {
+	if (m_file == nullptr) return;
+
+	pthread_mutex_lock(&m_mutex);
+	m_payload.resize(0);
+	if (kind == TRAFFIC_DELETE) {
+		put_str(m_payload, property->device);
+		put_str(m_payload, property->name);
+		put_str(m_payload, property->group);
+		put_str(m_payload, message);
+	} else {
+		put_u8(m_payload, property->type);
+		put_u8(m_payload, property->state);
+		put_u8(m_payload, property->perm);
+		put_u8(m_payload, property->rule);
+		put_u16(m_payload, property->count);
+		put_str(m_payload, property->device);
+		put_str(m_payload, property->name);
+		put_str(m_payload, property->group);
+		put_str(m_payload, property->label);
+		put_str(m_payload, message);
+		for (int i = 0; i < property->count; i++) {
+			indigo_item *item = &property->items[i];
+			put_str(m_payload, item->name);
+			put_str(m_payload, item->label);
+			switch (property->type) {
+			case INDIGO_TEXT_VECTOR:
+				put_str(m_payload, item->text.value);
+				break;
+			case INDIGO_NUMBER_VECTOR:
+				put_str(m_payload, item->number.format);
+				put_f64(m_payload, item->number.min);
+				put_f64(m_payload, item->number.max);
+				put_f64(m_payload, item->number.step);
+				put_f64(m_payload, item->number.value);
+				put_f64(m_payload, item->number.target);
+				break;
+			case INDIGO_SWITCH_VECTOR:
+				put_u8(m_payload, item->sw.value);
+				break;
+			case INDIGO_LIGHT_VECTOR:
+				put_u8(m_payload, item->light.value);
+				break;
+			case INDIGO_BLOB_VECTOR:
+				put_str(m_payload, item->blob.format);
+				put_u32(m_payload, (quint32)item->blob.size);
+				break;
+			}
+		}
+	}
+	write_record(kind);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+void TrafficLog::record_message(const char *device, const char *message) {
+	if (m_file == nullptr) return;
+
+	pthread_mutex_lock(&m_mutex);
+	m_payload.resize(0);
+	put_str(m_payload, device);
+	put_str(m_payload, message);
+	write_record(TRAFFIC_MESSAGE);
+	pthread_mutex_unlock(&m_mutex);
+}
+
+
+/* Called with m_mutex held and the payload encoded */
+void TrafficLog::write_record(traffic_kind kind) {
+	if (m_file == nullptr) return;
+
+	struct timeval now;
+	gettimeofday(&now, nullptr);
+	quint64 usec = (quint64)(now.tv_sec - m_start.tv_sec) * 1000000 + (now.tv_usec - m_start.tv_usec);
+
+	QByteArray header;
+	put_u8(header, kind);
+	usec = qToLittleEndian(usec);
+	header.append((const char *)&usec, sizeof(usec));
+	put_u32(header, m_payload.size());
+
+	if (fwrite(header.constData(), header.size(), 1, m_file) != 1 ||
+	    (m_payload.size() && fwrite(m_payload.constData(), m_payload.size(), 1, m_file) != 1)) {
+		indigo_error("Traffic log write failed, recording stopped\n");
+		fclose(m_file);
+		m_file = nullptr;
+		return;
+	}
+	m_events++;
+}
@@ -0,0 +1,107 @@
+// Copyright (c) 2019 Rumen G.Bogdanovski
+// All rights reserved.
+//
+// You can use this software under the terms of 'INDIGO Astronomy
+// open-source license' (see LICENSE.md).
+//
+// THIS SOFTWARE IS PROVIDED BY THE AUTHORS 'AS IS' AND ANY EXPRESS
+// OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+// GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+// WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+// NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef TRAFFICLOG_H
+#define TRAFFICLOG_H
+
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <QByteArray>
+#include <indigo/indigo_bus.h>
+
+/* Traffic log file layout, all numbers little endian:
+
+   header:  "ICPTRAFF" u32 version
+   record:  u8 kind, u64 microseconds since recording started, u32 payload size, payload
+
+   define / update payload:
+            u8 type, u8 state, u8 perm, u8 rule, u16 count,
+            str device, str name, str group, str label, str message, items
+   item:    str name, str label, then by property type
+            text: str value; number: str format, f64 min, max, step, value, target
+            switch / light: u8 value; blob: str format, u32 size (data is not kept)
+   delete:  str device, str name, str group, str message
+   message: str device, str message
+
+   str is u16 length followed by the bytes, without the terminating zero.
+*/
+#define TRAFFIC_MAGIC "ICPTRAFF"
+#define TRAFFIC_VERSION 1
+
+typedef enum {
+	TRAFFIC_DEFINE = 1,
+	TRAFFIC_UPDATE = 2,
+	TRAFFIC_DELETE = 3,
+	TRAFFIC_MESSAGE = 4
+} traffic_kind;
+
+struct traffic_event {
+	traffic_kind kind;
+	unsigned long long usec;
+	/* define, update and delete, release with indigo_release_property() */
+	indigo_property *property;
+	char device[INDIGO_NAME_SIZE];
+	char message[INDIGO_VALUE_SIZE];
+	bool has_message;
+};
+
+/* Opens a traffic log for reading and checks its header */
+FILE* traffic_open(const char *path);
+
+/* Reads the next event, false at the end of the log or on a damaged record */
+bool traffic_read(FILE *file, traffic_event *event);
+
+
+/* Records the property traffic seen by the client callbacks. record() is
+   called on the indigo threads, it encodes the event into a reused buffer
+   and appends it to the log under a mutex.
+*/
+class TrafficLog {
+public:
+	static TrafficLog& instance();
+
+	bool open(const char *path);
+	void close();
+	bool recording() const { return m_file != nullptr; }
+
+	void record(traffic_kind kind, indigo_property *property, const char *message);
+	void record_message(const char *device, const char *message);
+
+	unsigned long events_recorded() const { return m_events; }
+
+private:
+	TrafficLog();
+
+	void write_record(traffic_kind kind);
+
+	FILE *m_file;
+	pthread_mutex_t m_mutex;
+	struct timeval m_start;
+	QByteArray m_payload;
+	unsigned long m_events;
+};
+
+inline TrafficLog& TrafficLog::instance() {
+	static TrafficLog* me = nullptr;
+	if (!me) me = new TrafficLog();
+	return *me;
+}
+
+#endif // TRAFFICLOG_H